@@ -220,6 +220,10 @@ bool TUioDevImpl::PinFuncAvailable(TPinCfg * pcf)
   {
     return (0 != (pinfo->flags & UIOFUNC_UART));
   }
+  else if (UIO_PINTYPE_COUNTER == pintype)
+  {
+    return false;  // no hardware counter support yet
+  }
   else
   {
     return true;
@@ -35,8 +35,12 @@
 #define UIO_SPI_COUNT       1
 #define UIO_SPIFLASH_COUNT  1
 
+#define UIO_SLCAN_ENABLE    1  // SLCAN CDC function for the CAN
+
 #define UIO_SPI_CS_COUNT    1
 
+#define UIO_DACWAVE_COUNT   3
+
 // UnivID Device settings
 
 #define UIO_FW_ID   "GenIO-SG473-48"
@@ -66,4 +70,8 @@
 #define DMACH_ADC1        0x201
 #define DMACH_ADC2        0x202
 
+#define DMACH_DACWAVE0    0x203
+#define DMACH_DACWAVE1    0x204
+#define DMACH_DACWAVE2    0x205
+
 #endif /* BOARD_H_ */
@@ -10,6 +10,11 @@
 
 #include <uio_dev_base.h>
 
+#define SG473_TIMUSE_FREE     0
+#define SG473_TIMUSE_PWM         1  // one PWM channel on the timer, the single pulse mode is available
+#define SG473_TIMUSE_COUNTER     2  // the counter occupies the whole timer
+#define SG473_TIMUSE_PWM_SHARED  3  // more PWM channels on the timer, no single pulse mode
+
 class TUioDevImpl : public TUioDevBase
 {
 private:
@@ -19,6 +24,8 @@ public:
 
   virtual bool      InitBoard();
   virtual bool      PinFuncAvailable(TPinCfg * pcf);
+  virtual uint16_t  PinSetup(uint8_t pinid, uint32_t pincfg, bool active);
+  virtual void      ConfigurePins(bool active);
 
   virtual void      SetupAdc(TPinCfg * pcf);
   virtual void      SetupDac(TPinCfg * pcf);
@@ -28,8 +35,27 @@ public:
   virtual void      SetupUart(TPinCfg * pcf);
   virtual void      SetupCan(TPinCfg * pcf);
   virtual void      SetupClockOut(TPinCfg * pcf);
+  virtual uint32_t  SetupCounter(TPinCfg * pcf);
+  virtual uint32_t  CounterHwValue(uint8_t acntidx);
+  virtual bool      StartBlpTimer();
+  virtual bool      SpiReconfigure(THwSpi * aspi);
+  virtual bool      PwmPulseStart(uint8_t apwmnum, uint32_t adelay, uint32_t awidth);
+  virtual bool      PwmPulseRunning(uint8_t apwmnum);
+  virtual void      PwmPulseStop(uint8_t apwmnum);
+  virtual bool      DacWaveStart(uint8_t adacnum, uint16_t * abuf, uint32_t asamples, uint32_t arate);
+  virtual void      DacWaveStop(uint8_t adacnum);
+  virtual void      DacWaveSetRate(uint8_t adacnum, uint32_t arate);
+  virtual uint32_t  DacWaveReadPos(uint8_t adacnum);
 
   virtual bool      LoadBuiltinConfig(uint8_t anum);
+
+public:
+  uint8_t           tim_usage[16] = {0};  // SG473_TIMUSE_*, by timer number, rebuilt by ConfigurePins()
+  TIM_TypeDef *     cnt_regs[UIO_CNT_COUNT] = {0};
+  TIM_TypeDef *     pwm_regs[UIO_PWM_COUNT] = {0};
+  uint8_t           pwm_chnum[UIO_PWM_COUNT] = {0};
+  DAC_TypeDef *     dac_regs[UIO_DAC_COUNT] = {0};
+  uint8_t           dac_chnum[UIO_DAC_COUNT] = {0};
 };
 
 #endif /* UIO_GENDEV_H_ */
@@ -130,6 +130,7 @@ bool TUioDevImpl::InitBoard()
   nvsaddr_nvdata = nvsaddr_setup + 16 * 1024;
 #endif
   nvs_sector_size = hwintflash.EraseSize(nvsaddr_setup);
+  nvs_nvdata_size = 16 * 1024;
 
   // SETUP RESERVED PINS / FUNCTIONS
 
@@ -233,12 +234,83 @@ bool TUioDevImpl::PinFuncAvailable(TPinCfg * pcf)
   {
     return (0 != (pinfo->flags & UIOFUNC_CAN));
   }
+  else if (UIO_PINTYPE_COUNTER == pintype)
+  {
+    // the TIM2-TIM4 channel 1 or 2 inputs can be used as external clock (TI1FP1, TI2FP2)
+    uint8_t timernum = (pinfo->pwm & 0xF);
+    uint8_t chnum    = ((pinfo->pwm >> 4) & 0xF);
+    return ((pinfo->pwm != 0) && (timernum >= 2) && (timernum <= 4) && (chnum >= 1) && (chnum <= 2));
+  }
   else
   {
     return true;
   }
 }
 
+void TUioDevImpl::ConfigurePins(bool active)
+{
+  unsigned n;
+
+  // stop the counters, the timers are claimed again by the pin setup
+  for (n = 0; n < UIO_CNT_COUNT; ++n)
+  {
+    if (cnt_regs[n])
+    {
+      cnt_regs[n]->CR1 = 0;
+      cnt_regs[n] = nullptr;
+    }
+  }
+
+  for (n = 0; n < sizeof(tim_usage); ++n)
+  {
+    tim_usage[n] = SG473_TIMUSE_FREE;
+  }
+
+  super::ConfigurePins(active);
+}
+
+uint16_t TUioDevImpl::PinSetup(uint8_t pinid, uint32_t pincfg, bool active)
+{
+  uint8_t pintype  = (pincfg & 0xFF);
+  uint8_t timernum = 0;
+  uint8_t timuse   = SG473_TIMUSE_FREE;
+
+  // a counter takes over its whole timer, so it can not share it with another counter or PWM
+  if (active && (pinid < UIO_PIN_COUNT))
+  {
+    if (UIO_PINTYPE_COUNTER == pintype)
+    {
+      timuse = SG473_TIMUSE_COUNTER;
+    }
+    else if (UIO_PINTYPE_PWM_OUT == pintype)
+    {
+      timuse = SG473_TIMUSE_PWM;
+    }
+
+    if (timuse)
+    {
+      timernum = (g_pininfo[pinid].pwm & 0xF);
+      uint8_t prevuse = tim_usage[timernum];
+      if ((SG473_TIMUSE_COUNTER == prevuse) || ((SG473_TIMUSE_FREE != prevuse) && (SG473_TIMUSE_COUNTER == timuse)))
+      {
+        return UIOERR_UNIT_ALREADY_IN_USE;
+      }
+      if (SG473_TIMUSE_FREE != prevuse)
+      {
+        timuse = SG473_TIMUSE_PWM_SHARED;
+      }
+    }
+  }
+
+  uint16_t result = super::PinSetup(pinid, pincfg, active);
+  if ((0 == result) && timuse)
+  {
+    tim_usage[timernum] = timuse;
+  }
+
+  return result;
+}
+
 void TUioDevImpl::SetupAdc(TPinCfg * pcf)
 {
   const TPinInfo * pinfo = &g_pininfo[pcf->pinid];
@@ -257,14 +329,20 @@ void TUioDevImpl::SetupDac(TPinCfg * pcf)
   if (5 == pcf->pinid) // PA5 ?
   {
   	dac->Init(1, 2);  // DAC1_OUT2
+  	dac_regs[pcf->unitnum] = DAC1;
+  	dac_chnum[pcf->unitnum] = 2;
   }
   else if (6 == pcf->pinid) // PA6 ?
   {
   	dac->Init(2, 1);  // DAC2_OUT1
+  	dac_regs[pcf->unitnum] = DAC2;
+  	dac_chnum[pcf->unitnum] = 1;
   }
   else // PA4
   {
   	dac->Init(1, 1);  // DAC1_OUT1
+  	dac_regs[pcf->unitnum] = DAC1;
+  	dac_chnum[pcf->unitnum] = 1;
   }
 
   pcf->hwpinflags = PINCFG_ANALOGUE;
@@ -280,6 +358,13 @@ void TUioDevImpl::SetupPwm(TPinCfg * pcf)
     return;
   }
 
+  uint8_t timernum = (pinfo->pwm & 0xF);
+  if      (2 == timernum)  pwm_regs[pcf->unitnum] = TIM2;
+  else if (3 == timernum)  pwm_regs[pcf->unitnum] = TIM3;
+  else if (4 == timernum)  pwm_regs[pcf->unitnum] = TIM4;
+  else                     pwm_regs[pcf->unitnum] = nullptr;
+  pwm_chnum[pcf->unitnum] = ((pinfo->pwm >> 4) & 0xF);
+
   pcf->hwpinflags = PINCFG_OUTPUT | PINCFG_AF_0 | (((pinfo->pwm >> 8) & 0xF) << PINCFG_AF_SHIFT);
 
 }
@@ -304,6 +389,18 @@ void TUioDevImpl::SetupI2c(TPinCfg * pcf)
   TGpioPin * ppin = &g_pins[pcf->pinid];
 
   pcf->hwpinflags = PINCFG_AF_4 | PINCFG_OPENDRAIN;
+
+  // for the bus recovery
+  if (15 == pcf->pinid) // A15 = I2C1_SCL
+  {
+    g_i2cctrl[0].scl_pin = ppin;
+    g_i2cctrl[0].scl_pinflags = pcf->hwpinflags;
+  }
+  else // B7 = I2C1_SDA
+  {
+    g_i2cctrl[0].sda_pin = ppin;
+    g_i2cctrl[0].sda_pinflags = pcf->hwpinflags;
+  }
 }
 
 void TUioDevImpl::SetupUart(TPinCfg * pcf)
@@ -333,6 +430,300 @@ void TUioDevImpl::SetupClockOut(TPinCfg * pcf)
   pcf->hwpinflags = PINCFG_OUTPUT | PINCFG_AF_0;
 }
 
+uint32_t TUioDevImpl::SetupCounter(TPinCfg * pcf)
+{
+  const TPinInfo *  pinfo = &g_pininfo[pcf->pinid];
+
+  uint8_t timernum = (pinfo->pwm & 0xF);
+  uint8_t chnum    = ((pinfo->pwm >> 4) & 0xF);
+  uint32_t hwmask  = 0xFFFF;
+
+  TIM_TypeDef * regs;
+  if (2 == timernum)
+  {
+    RCC->APB1ENR1 |= RCC_APB1ENR1_TIM2EN;
+    regs = TIM2;
+    hwmask = 0xFFFFFFFF;  // 32-bit timer
+  }
+  else if (3 == timernum)
+  {
+    RCC->APB1ENR1 |= RCC_APB1ENR1_TIM3EN;
+    regs = TIM3;
+  }
+  else if (4 == timernum)
+  {
+    RCC->APB1ENR1 |= RCC_APB1ENR1_TIM4EN;
+    regs = TIM4;
+  }
+  else
+  {
+    return 0;
+  }
+
+  // the timer counts the input edges in external clock mode 1,
+  // a PWM output on the same timer can not be used in parallel (rejected by the PinSetup())
+
+  regs->CR1 = 0;
+  regs->CCER = 0;
+  if (1 == chnum)
+  {
+    regs->CCMR1 = (1 << 0) | (3 << 4);  // CC1S = 1: IC1 = TI1, IC1F = 3: 8 samples filter
+    regs->SMCR  = (7 << 0) | (5 << 4);  // SMS = 7: external clock mode 1, TS = 5: TI1FP1
+    if (pcf->flags & 0x0004)  regs->CCER = (1 << 1);  // CC1P: falling edge
+  }
+  else
+  {
+    regs->CCMR1 = (1 << 8) | (3 << 12);  // CC2S = 1: IC2 = TI2, IC2F = 3: 8 samples filter
+    regs->SMCR  = (7 << 0) | (6 << 4);   // SMS = 7: external clock mode 1, TS = 6: TI2FP2
+    if (pcf->flags & 0x0004)  regs->CCER = (1 << 5);  // CC2P: falling edge
+  }
+  regs->PSC = 0;
+  regs->ARR = hwmask;
+  regs->EGR = 1;  // UG: load the prescaler
+  regs->CNT = 0;
+  regs->CR1 = TIM_CR1_CEN;
+
+  cnt_regs[pcf->unitnum] = regs;
+
+  pcf->hwpinflags |= (((pinfo->pwm >> 8) & 0xF) << PINCFG_AF_SHIFT);
+
+  return hwmask;
+}
+
+uint32_t TUioDevImpl::CounterHwValue(uint8_t acntidx)
+{
+  TIM_TypeDef * regs = cnt_regs[acntidx];
+  if (!regs)
+  {
+    return 0;
+  }
+  return regs->CNT;
+}
+
+// PWM single pulse mode using the timer one-pulse mode (OPM):
+//   the counter runs once from 0 to delay + width - 1 and stops, the channel
+//   works in PWM mode 2, so the output is active when CNT >= CCR (= delay).
+//   The OPM and the ARR belong to the whole timer, so the single pulse is only
+//   available when no other PWM channel uses the same timer.
+
+static void set_pwm_ocmode(TIM_TypeDef * regs, uint8_t chnum, uint32_t aocm)
+{
+  volatile uint32_t * ccmr = (chnum <= 2 ? &regs->CCMR1 : &regs->CCMR2);
+  uint32_t shift = ((chnum - 1) & 1) * 8;
+  *ccmr = (*ccmr & ~(0x00010070 << shift)) | (aocm << (4 + shift));
+}
+
+static volatile uint32_t * pwm_ccr(TIM_TypeDef * regs, uint8_t chnum)
+{
+  return (&regs->CCR1 + (chnum - 1));
+}
+
+bool TUioDevImpl::PwmPulseStart(uint8_t apwmnum, uint32_t adelay, uint32_t awidth)
+{
+  TIM_TypeDef * regs = pwm_regs[apwmnum];
+  if (!regs || (pwm_chnum[apwmnum] < 1) || (pwm_chnum[apwmnum] > 4))
+  {
+    return false;
+  }
+
+  uint8_t timernum = (regs == TIM2 ? 2 : (regs == TIM3 ? 3 : 4));
+  if (SG473_TIMUSE_PWM != tim_usage[timernum])
+  {
+    return false;  // shared timer
+  }
+
+  uint32_t arr = adelay + awidth - 1;
+  if ((regs != TIM2) && (arr > 0xFFFF))  // only the TIM2 has 32-bit counter
+  {
+    return false;
+  }
+
+  regs->CR1 &= ~TIM_CR1_CEN;
+  regs->CR1 |= TIM_CR1_OPM;
+  set_pwm_ocmode(regs, pwm_chnum[apwmnum], 7);  // PWM mode 2
+  regs->ARR = arr;
+  *pwm_ccr(regs, pwm_chnum[apwmnum]) = adelay;
+  regs->EGR = TIM_EGR_UG;  // load the preloaded registers, clears the counter
+  regs->CR1 |= TIM_CR1_CEN;
+
+  return true;
+}
+
+bool TUioDevImpl::PwmPulseRunning(uint8_t apwmnum)
+{
+  TIM_TypeDef * regs = pwm_regs[apwmnum];
+  return (regs && (regs->CR1 & TIM_CR1_CEN));  // the OPM clears the CEN at the end
+}
+
+void TUioDevImpl::PwmPulseStop(uint8_t apwmnum)
+{
+  TIM_TypeDef * regs = pwm_regs[apwmnum];
+  if (!regs)
+  {
+    return;
+  }
+
+  THwPwmChannel * pwm = &g_pwm[apwmnum];
+
+  regs->CR1 &= ~(TIM_CR1_CEN | TIM_CR1_OPM);
+  set_pwm_ocmode(regs, pwm_chnum[apwmnum], 6);  // PWM mode 1
+  regs->ARR = pwm->periodclocks - 1;
+  regs->EGR = TIM_EGR_UG;
+  regs->CR1 |= TIM_CR1_CEN;
+}
+
+// DAC waveform generator: the DAC units 0-2 use fixed timers for the sample triggering
+//   unit 0: TIM6 (TSEL = 7), unit 1: TIM15 (TSEL = 3), unit 2: TIM8 (TSEL = 1)
+
+THwDmaChannel  g_dma_dacwave[UIO_DACWAVE_COUNT];
+
+static TIM_TypeDef * const  dacwave_timer[UIO_DACWAVE_COUNT] = { TIM6, TIM15, TIM8 };
+static const uint8_t        dacwave_tsel[UIO_DACWAVE_COUNT]  = { 7, 3, 1 };
+static const uint16_t       dacwave_dmach[UIO_DACWAVE_COUNT] = { DMACH_DACWAVE0, DMACH_DACWAVE1, DMACH_DACWAVE2 };
+
+void TUioDevImpl::DacWaveSetRate(uint8_t adacnum, uint32_t arate)
+{
+  TIM_TypeDef * regs = dacwave_timer[adacnum];
+
+  // the timer clocks are the same as the SystemCoreClock (APB prescalers = 1)
+  uint32_t clocks = SystemCoreClock / arate;
+  uint32_t psc = (clocks >> 16);
+  regs->PSC = psc;  // PSC and ARR are preloaded, they are activated at the next update
+  regs->ARR = (clocks / (psc + 1)) - 1;
+}
+
+bool TUioDevImpl::DacWaveStart(uint8_t adacnum, uint16_t * abuf, uint32_t asamples, uint32_t arate)
+{
+  DAC_TypeDef * dregs = dac_regs[adacnum];
+  if ((adacnum >= UIO_DACWAVE_COUNT) || !dregs)
+  {
+    return false;
+  }
+
+  uint8_t  ch = dac_chnum[adacnum];
+  unsigned crshift = (2 == ch ? 16 : 0);
+  unsigned dmarq;
+  if (DAC2 == dregs)  dmarq = 41;      // DAC2_CH1
+  else if (2 == ch)   dmarq = 7;       // DAC1_CH2
+  else                dmarq = 6;       // DAC1_CH1
+
+  if      (TIM6  == dacwave_timer[adacnum])  RCC->APB1ENR1 |= RCC_APB1ENR1_TIM6EN;
+  else if (TIM15 == dacwave_timer[adacnum])  RCC->APB2ENR  |= RCC_APB2ENR_TIM15EN;
+  else                                       RCC->APB2ENR  |= RCC_APB2ENR_TIM8EN;
+
+  TIM_TypeDef * tregs = dacwave_timer[adacnum];
+  tregs->CR1 = TIM_CR1_ARPE;
+  tregs->CR2 = (2 << TIM_CR2_MMS_Pos);  // TRGO = update
+  DacWaveSetRate(adacnum, arate);
+  tregs->EGR = TIM_EGR_UG;
+
+  THwDmaChannel * pdma = &g_dma_dacwave[adacnum];
+  pdma->Init((dacwave_dmach[adacnum] >> 8), dacwave_dmach[adacnum] & 7, dmarq);
+  pdma->Prepare(true, (void *)(2 == ch ? &dregs->DHR12L2 : &dregs->DHR12L1), 0);
+
+  THwDmaTransfer xfer;
+  xfer.srcaddr = abuf;
+  xfer.bytewidth = 2;
+  xfer.count = asamples;
+  xfer.flags = DMATR_CIRCULAR;
+  pdma->StartTransfer(&xfer);
+
+  // the trigger selection can be changed only when the channel is disabled
+  uint32_t cr = dregs->CR & ~(0xFFFF << crshift);
+  dregs->CR = cr;
+  cr |= ((DAC_CR_TEN1 | (dacwave_tsel[adacnum] << DAC_CR_TSEL1_Pos) | DAC_CR_DMAEN1) << crshift);
+  dregs->CR = cr;
+  dregs->CR = cr | (DAC_CR_EN1 << crshift);
+
+  tregs->CR1 |= TIM_CR1_CEN;
+
+  return true;
+}
+
+void TUioDevImpl::DacWaveStop(uint8_t adacnum)
+{
+  DAC_TypeDef * dregs = dac_regs[adacnum];
+  if ((adacnum >= UIO_DACWAVE_COUNT) || !dregs)
+  {
+    return;
+  }
+
+  unsigned crshift = (2 == dac_chnum[adacnum] ? 16 : 0);
+
+  dacwave_timer[adacnum]->CR1 = 0;
+  g_dma_dacwave[adacnum].Disable();
+
+  // back to the software triggered (direct) mode
+  uint32_t cr = dregs->CR & ~(0xFFFF << crshift);
+  dregs->CR = cr;
+  dregs->CR = cr | (DAC_CR_EN1 << crshift);
+}
+
+uint32_t TUioDevImpl::DacWaveReadPos(uint8_t adacnum)
+{
+  TUioDacWave * pw = &dacwave[adacnum];
+  return 2 * pw->samples - g_dma_dacwave[adacnum].Remaining();
+}
+
+// TIM7 generates the LED blink pattern ticks
+
+#define BLP_TIMER_IRQ_NUM   55  // TIM7_DAC_IRQn
+
+extern "C" void IRQ_Handler_55()
+{
+  TIM7->SR = ~TIM_SR_UIF;
+  g_uiodev.LedBlpTick();
+}
+
+bool TUioDevImpl::StartBlpTimer()
+{
+  RCC->APB1ENR1 |= RCC_APB1ENR1_TIM7EN;
+
+  TIM7->CR1 = 0;
+  TIM7->PSC = (SystemCoreClock / 1000000) - 1;  // 1 MHz timer clock (APB1 prescaler = 1)
+  TIM7->ARR = (1000000 / UIO_BLP_TICK_HZ) - 1;
+  TIM7->EGR = TIM_EGR_UG;
+  TIM7->SR = 0;
+  TIM7->DIER = TIM_DIER_UIE;
+  TIM7->CR1 = TIM_CR1_CEN;
+
+  // low priority, the pin updates are short
+  mcu_irq_priority_set(BLP_TIMER_IRQ_NUM, 12);
+  mcu_irq_pending_clear(BLP_TIMER_IRQ_NUM);
+  mcu_irq_enable(BLP_TIMER_IRQ_NUM);
+
+  return true;
+}
+
+// SPI2 speed / mode change without the full SPI and DMA re-initialization
+
+bool TUioDevImpl::SpiReconfigure(THwSpi * aspi)
+{
+  if (aspi != &g_spi[0])
+  {
+    return false;
+  }
+
+  // SPI2 runs from the APB1 clock = SystemCoreClock
+  uint32_t brdiv = 0;
+  while ((brdiv < 7) && ((SystemCoreClock >> (brdiv + 1)) > aspi->speed))
+  {
+    ++brdiv;
+  }
+
+  uint32_t cr1 = SPI2->CR1;
+  cr1 &= ~(SPI_CR1_BR | SPI_CR1_CPOL | SPI_CR1_CPHA | SPI_CR1_LSBFIRST | SPI_CR1_SPE);
+  cr1 |= (brdiv << SPI_CR1_BR_Pos);
+  if (aspi->idleclk_high)     cr1 |= SPI_CR1_CPOL;
+  if (aspi->datasample_late)  cr1 |= SPI_CR1_CPHA;
+  if (aspi->lsb_first)        cr1 |= SPI_CR1_LSBFIRST;
+
+  SPI2->CR1 = cr1;  // must be disabled for the changes
+  SPI2->CR1 = cr1 | SPI_CR1_SPE;
+
+  return true;
+}
+
 bool TUioDevImpl::LoadBuiltinConfig(uint8_t anum)
 {
   return false;
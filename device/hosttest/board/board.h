@@ -0,0 +1,49 @@
+/*
+ *  file:     board.h
+ *  brief:    UnivIO host test board, the peripherals are simulated by the stubs
+ *  created:  2026-10-19
+ *  authors:  nvitya
+*/
+
+#ifndef BOARD_H_
+#define BOARD_H_
+
+#define BOARD_NAME "Host Test"
+
+#define USB_ENABLE        1
+#define UART_CTRL_ENABLE  0
+#define USB_UART_ENABLE   1
+#ifndef HAS_SPI_FLASH
+  #define HAS_SPI_FLASH   0  // the Makefile builds a variant with 1 too
+#endif
+#define SPI_SELF_FLASHING 0
+
+#define UIO_UART_COUNT      1
+#define UIO_CAN_COUNT       1
+#define UIO_I2C_COUNT       1
+#define UIO_SPI_COUNT       1
+#define UIO_SPIFLASH_COUNT  1
+
+#define UIO_SLCAN_ENABLE    1
+
+#define UIO_SPI_CS_COUNT    1
+
+#define UIO_DACWAVE_COUNT   1
+
+// UnivID Device settings
+
+#define UIO_FW_ID   "GenIO-HostTest"
+#define UIO_FW_VER         ((0 << 24) | (5 << 16) | 1)
+#define UIO_MEM_SIZE       0x8000 // for OBJ#0002
+
+#define UIO_MAX_DATA_LEN     1024
+#define UIO_MPRAM_SIZE       (32*1024)
+
+// UnivIO Generic Device settings
+
+#define UIO_PINS_PER_PORT  16
+#define UIO_PIN_COUNT      48
+
+#define UIOMCU_ADC_COUNT    2
+
+#endif /* BOARD_H_ */
@@ -0,0 +1,56 @@
+/*
+ *  file:     uio_dev_host.cpp
+ *  brief:    UnivIO host test board implementation
+ *  created:  2026-10-19
+ *  authors:  nvitya
+*/
+
+#include "uio_device.h"
+#include "hwintflash.h"
+#include "spiflash.h"
+#include "board_pins.h"
+
+TCanMsg   can_rxbuf[UIO_CAN_COUNT][16];
+TCanMsg   can_txbuf[UIO_CAN_COUNT][16];
+
+bool TUioDevImpl::InitBoard()
+{
+  unsigned n;
+
+  for (n = 0; n < UIO_SPI_COUNT;  ++n)  g_spi[n].Init(n);
+  for (n = 0; n < UIO_I2C_COUNT;  ++n)  g_i2c[n].Init(n);
+  for (n = 0; n < UIO_UART_COUNT; ++n)  g_uart[n].Init(n);
+  for (n = 0; n < UIO_CAN_COUNT;  ++n)
+  {
+    g_can[n].Init(n, &can_rxbuf[n][0], 16, &can_txbuf[n][0], 16);
+  }
+
+#if HAS_SPI_FLASH
+  spiflash.spi = &g_spi[0];
+  spiflash.Init();
+
+  nvsaddr_setup   = 0x10000;
+  nvsaddr_nvdata  = nvsaddr_setup + 16 * 1024;
+  nvs_sector_size = spiflash.erase_size;
+#else
+  nvsaddr_setup   = hwintflash.start_address + 96 * 1024;
+  nvsaddr_nvdata  = nvsaddr_setup + 16 * 1024;
+  nvs_sector_size = hwintflash.EraseSize(nvsaddr_setup);
+#endif
+  nvs_nvdata_size = 16 * 1024;
+
+  return true;
+}
+
+bool TUioDevImpl::DacWaveStart(uint8_t adacnum, uint16_t * abuf, uint32_t asamples, uint32_t arate)
+{
+  dacwave_pos[adacnum] = 0;
+  return true;
+}
+
+uint32_t TUioDevImpl::DacWaveReadPos(uint8_t adacnum)
+{
+  uint32_t r = dacwave_pos[adacnum];
+  dacwave_pos[adacnum] = (r + dacwave_pos_step[adacnum]) % (2 * dacwave[adacnum].samples);
+  return r;
+}
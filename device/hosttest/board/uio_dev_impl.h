@@ -0,0 +1,35 @@
+/*
+ *  file:     uio_dev_impl.h
+ *  brief:    UnivIO host test board implementation headers
+ *  created:  2026-10-19
+ *  authors:  nvitya
+*/
+
+#ifndef UIO_GENDEV_H_
+#define UIO_GENDEV_H_
+
+#include <uio_dev_base.h>
+
+class TUioDevImpl : public TUioDevBase
+{
+private:
+  typedef TUioDevBase  super;
+
+public:
+  virtual bool      InitBoard();
+  virtual bool      PinFuncAvailable(TPinCfg * pcf) { return true; }
+  virtual uint32_t  SetupCounter(TPinCfg * pcf) { return 0xFFFF; }
+  virtual uint32_t  CounterHwValue(uint8_t acntidx) { return cnt_hwvalue[acntidx]; }
+
+  virtual bool      DacWaveStart(uint8_t adacnum, uint16_t * abuf, uint32_t asamples, uint32_t arate);
+  virtual void      DacWaveStop(uint8_t adacnum) { }
+  virtual void      DacWaveSetRate(uint8_t adacnum, uint32_t arate) { }
+  virtual uint32_t  DacWaveReadPos(uint8_t adacnum);
+
+public:  // simulated hardware state, set by the tests
+  uint32_t          cnt_hwvalue[UIO_CNT_COUNT] = {0};
+  uint32_t          dacwave_pos[UIO_DACWAVE_COUNT] = {0};
+  uint32_t          dacwave_pos_step[UIO_DACWAVE_COUNT] = {0};  // the DMA moves by this between two reads
+};
+
+#endif /* UIO_GENDEV_H_ */
@@ -0,0 +1,39 @@
+/*
+ *  file:     hosttest.h
+ *  brief:    UnivIO host test helpers
+*/
+
+#ifndef HOSTTEST_H_
+#define HOSTTEST_H_
+
+#include "stdio.h"
+#include "platform.h"
+#include "hostflash.h"
+
+extern unsigned  test_checks;
+extern unsigned  test_failures;
+
+#define TEST_CHECK(cond)  do { \
+    ++test_checks; \
+    if (!(cond)) \
+    { \
+      ++test_failures; \
+      printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+    } \
+  } while (0)
+
+THostFlash *  test_nvflash();       // the flash of the NV storage
+void          test_run(unsigned acount = 1);  // main loop iterations, advances the clock by 10 us each
+
+// UDO requests through the application handler, return the UDO result code (0 = ok)
+uint16_t      test_udo_write(uint16_t aindex, const void * adata, unsigned alen, uint32_t aoffset = 0);
+uint16_t      test_udo_read(uint16_t aindex, void * rdata, unsigned amaxlen, unsigned * ranslen = nullptr, uint32_t aoffset = 0);
+
+// test groups
+void          test_nvstorage();
+void          test_can();
+void          test_slcan();
+void          test_dacwave();
+void          test_nvdata();
+
+#endif
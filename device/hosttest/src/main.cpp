@@ -0,0 +1,87 @@
+/*
+ *  file:     main.cpp
+ *  brief:    UnivIO host tests
+*/
+
+#include "hosttest.h"
+#include "uio_device.h"
+#include "hwintflash.h"
+#include "board_pins.h"
+#include "udoslaveapp.h"
+
+unsigned  test_checks = 0;
+unsigned  test_failures = 0;
+
+THostFlash * test_nvflash()
+{
+  #if HAS_SPI_FLASH
+    return &spiflash;
+  #else
+    return &hwintflash;
+  #endif
+}
+
+void test_run(unsigned acount)
+{
+  while (acount)
+  {
+    host_clockcnt += SystemCoreClock / 100000;
+    g_uiodev.Run();
+    host_port_update();
+    --acount;
+  }
+}
+
+uint16_t test_udo_write(uint16_t aindex, const void * adata, unsigned alen, uint32_t aoffset)
+{
+  uint8_t      buf[UIO_MAX_DATA_LEN];
+  TUdoRequest  rq;
+
+  memcpy(&buf[0], adata, alen);
+  memset(&rq, 0, sizeof(rq));
+  rq.iswrite = 1;
+  rq.index = aindex;
+  rq.offset = aoffset;
+  rq.rqlen = alen;
+  rq.maxanslen = sizeof(buf);
+  rq.dataptr = &buf[0];
+  udoslave_app_read_write(&rq);
+  return rq.result;
+}
+
+uint16_t test_udo_read(uint16_t aindex, void * rdata, unsigned amaxlen, unsigned * ranslen, uint32_t aoffset)
+{
+  uint8_t      buf[UIO_MAX_DATA_LEN];
+  TUdoRequest  rq;
+
+  memset(&rq, 0, sizeof(rq));
+  rq.iswrite = 0;
+  rq.index = aindex;
+  rq.offset = aoffset;
+  rq.maxanslen = (amaxlen < sizeof(buf) ? amaxlen : sizeof(buf));
+  rq.dataptr = &buf[0];
+  udoslave_app_read_write(&rq);
+  memcpy(rdata, &buf[0], rq.anslen);
+  if (ranslen)  *ranslen = rq.anslen;
+  return rq.result;
+}
+
+int main(int argc, char ** argv)
+{
+  printf("UnivIO host test, %s flash\n", (HAS_SPI_FLASH ? "SPI" : "internal"));
+
+  if (!g_uiodev.Init())
+  {
+    printf("device init failed\n");
+    return 1;
+  }
+
+  test_nvstorage();
+  test_nvdata();
+  test_can();
+  test_slcan();
+  test_dacwave();
+
+  printf("%u checks, %u failed\n", test_checks, test_failures);
+  return (test_failures ? 1 : 0);
+}
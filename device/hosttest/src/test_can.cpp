@@ -0,0 +1,301 @@
+/*
+ *  file:     test_can.cpp
+ *  brief:    CAN message conversion and acceptance filter tests
+*/
+
+#include "hosttest.h"
+#include "uio_device.h"
+#include "uio_can_control.h"
+
+static TUioCanCtrl * canctrl = &g_canctrl[0];
+static THwCan *      can = &g_can[0];
+
+static void can_msg(TCanMsg * hmsg, uint32_t acobid, uint8_t alen)
+{
+  memset(hmsg, 0, sizeof(*hmsg));
+  hmsg->cobid = acobid;
+  hmsg->len = alen;
+  for (unsigned n = 0; n < 8; ++n)
+  {
+    hmsg->data[n] = 0x11 * (n + 1);
+  }
+}
+
+static void can_restart()
+{
+  uint32_t ctrl = (UIO_CAN_CTRL_ACTIVE << 16);
+  TEST_CHECK(0 == test_udo_write(0x1801, &ctrl, 4));
+
+  memset(&canctrl->filters[0], 0, sizeof(canctrl->filters));
+  memset(&canctrl->xfilters[0], 0, sizeof(canctrl->xfilters));
+  canctrl->swf_ctrl = 0;
+  canctrl->SetRxRing(0, 0);
+
+  ctrl = UIO_CAN_CTRL_ACTIVE;
+  TEST_CHECK(0 == test_udo_write(0x1801, &ctrl, 4));
+}
+
+static void test_can_msg_conversion()
+{
+  TUioCanMsg  umsg;
+  TUioCanMsg  umsg2;
+  TCanMsg     hmsg;
+
+  memset(&umsg, 0, sizeof(umsg));
+  for (unsigned n = 0; n < 8; ++n)
+  {
+    umsg.data[n] = n + 1;
+  }
+
+  // standard
+  umsg.can_id = 0x123;
+  umsg.can_dlc = 8;
+  TEST_CHECK(canctrl->MsgToHw(&umsg, &hmsg));
+  TEST_CHECK(0x123 == hmsg.cobid);
+  TEST_CHECK((8 == hmsg.len) && (8 == hmsg.data[7]));
+
+  // the std id is limited to 11 bits
+  umsg.can_id = 0x1FFFF123;
+  TEST_CHECK(canctrl->MsgToHw(&umsg, &hmsg));
+  TEST_CHECK(0x123 == hmsg.cobid);
+
+  // extended
+  umsg.can_id = UIO_CAN_ID_EXT | 0x1ABCDE12;
+  TEST_CHECK(canctrl->MsgToHw(&umsg, &hmsg));
+  TEST_CHECK((HWCAN_EXT_FLAG | 0x1ABCDE12) == hmsg.cobid);
+  canctrl->MsgFromHw(&hmsg, &umsg2);
+  TEST_CHECK(umsg.can_id == umsg2.can_id);
+  TEST_CHECK((8 == umsg2.can_dlc) && (0 == memcmp(&umsg.data[0], &umsg2.data[0], 8)));
+
+  // extended RTR
+  umsg.can_id = UIO_CAN_ID_EXT | UIO_CAN_ID_RTR | 0x00000001;
+  umsg.can_dlc = 4;
+  TEST_CHECK(canctrl->MsgToHw(&umsg, &hmsg));
+  TEST_CHECK((HWCAN_EXT_FLAG | HWCAN_RTR_FLAG | 1) == hmsg.cobid);
+  canctrl->MsgFromHw(&hmsg, &umsg2);
+  TEST_CHECK(umsg.can_id == umsg2.can_id);
+  TEST_CHECK(4 == umsg2.can_dlc);
+
+  // standard RTR
+  umsg.can_id = UIO_CAN_ID_RTR | 0x7FF;
+  TEST_CHECK(canctrl->MsgToHw(&umsg, &hmsg));
+  TEST_CHECK((HWCAN_RTR_FLAG | 0x7FF) == hmsg.cobid);
+  canctrl->MsgFromHw(&hmsg, &umsg2);
+  TEST_CHECK(umsg.can_id == umsg2.can_id);
+
+  // invalid length
+  umsg.can_id = 0x100;
+  umsg.can_dlc = 9;
+  TEST_CHECK(!canctrl->MsgToHw(&umsg, &hmsg));
+}
+
+static void test_can_send()
+{
+  can_restart();
+
+  TUioCanMsg  umsg[3];
+  memset(&umsg[0], 0, sizeof(umsg));
+  umsg[0].can_id = 0x100;
+  umsg[0].can_dlc = 2;
+  umsg[1].can_id = UIO_CAN_ID_EXT | 0x12345678;
+  umsg[1].can_dlc = 8;
+  umsg[2].can_id = UIO_CAN_ID_EXT | UIO_CAN_ID_RTR | 0x1FFFFFFF;
+  umsg[2].can_dlc = 0;
+
+  unsigned sent_start = can->sent_cnt;
+  TEST_CHECK(0 == test_udo_write(0x1805, &umsg[0], sizeof(umsg)));
+  test_run();
+  TEST_CHECK(sent_start + 3 == can->sent_cnt);
+  TEST_CHECK(0x100 == can->sent[sent_start + 0].cobid);
+  TEST_CHECK((HWCAN_EXT_FLAG | 0x12345678) == can->sent[sent_start + 1].cobid);
+  TEST_CHECK((HWCAN_EXT_FLAG | HWCAN_RTR_FLAG | 0x1FFFFFFF) == can->sent[sent_start + 2].cobid);
+
+  // a request with an invalid message sends nothing
+  umsg[1].can_dlc = 9;
+  TEST_CHECK(UDOERR_WRITE_VALUE == test_udo_write(0x1805, &umsg[0], sizeof(umsg)));
+  test_run();
+  TEST_CHECK(sent_start + 3 == can->sent_cnt);
+}
+
+static void test_can_xfilters()
+{
+  TCanMsg  hmsg;
+
+  // no filters: everything is received
+  can_restart();
+  can_msg(&hmsg, 0x123, 8);
+  TEST_CHECK(can->InjectRx(&hmsg));
+  can_msg(&hmsg, HWCAN_EXT_FLAG | 0x1ABCDE12, 8);
+  TEST_CHECK(can->InjectRx(&hmsg));
+  test_run();
+  TEST_CHECK(2 == canctrl->mstatus.rx_cnt);
+
+  // one 29-bit filter: the PGN range 0x18FFxxxx
+  uint32_t xf[3] = {1, 0x18FF0000, 0x1FFF0000};
+  TEST_CHECK(0 == test_udo_write(0x180B, &xf[0], sizeof(xf)));
+  TEST_CHECK(can->filter_cnt >= 1);
+
+  can_msg(&hmsg, HWCAN_EXT_FLAG | 0x18FF1234, 8);
+  TEST_CHECK(can->InjectRx(&hmsg));
+  can_msg(&hmsg, HWCAN_EXT_FLAG | HWCAN_RTR_FLAG | 0x18FFABCD, 0);
+  TEST_CHECK(can->InjectRx(&hmsg));
+  can_msg(&hmsg, HWCAN_EXT_FLAG | 0x18FE1234, 8);
+  TEST_CHECK(!can->InjectRx(&hmsg));
+  can_msg(&hmsg, 0x123, 8);  // no std filter: the standard frames are not received
+  TEST_CHECK(!can->InjectRx(&hmsg));
+  can_msg(&hmsg, 0x0FF, 8);  // the 11-bit part of the ext filter does not match std ids
+  TEST_CHECK(!can->InjectRx(&hmsg));
+  test_run();
+  TEST_CHECK(4 == canctrl->mstatus.rx_cnt);
+
+  // read back the filter table
+  uint32_t xfr[1 + 2 * UIO_CAN_XFILTER_MAX];
+  unsigned anslen = 0;
+  TEST_CHECK(0 == test_udo_read(0x180B, &xfr[0], sizeof(xfr), &anslen));
+  TEST_CHECK((sizeof(xfr) == anslen) && (1 == xfr[0]) && (0x18FF0000 == xfr[1]) && (0x1FFF0000 == xfr[2]));
+
+  // too many filters
+  uint32_t xcnt = UIO_CAN_XFILTER_MAX + 1;
+  TEST_CHECK(UDOERR_WRITE_VALUE == test_udo_write(0x180B, &xcnt, 4));
+  TEST_CHECK(0 == canctrl->xfilters[0]);
+
+  // packed read: the RTR frame has no data bytes
+  uint8_t  rdbuf[256];
+  TEST_CHECK(0 == test_udo_read(0x180C, &rdbuf[0], sizeof(rdbuf), &anslen, 2));
+  TEST_CHECK(8 + (7 + 8) + 7 == anslen);
+  uint32_t id;
+  memcpy(&id, &rdbuf[8], 4);
+  TEST_CHECK((UIO_CAN_ID_EXT | 0x18FF1234) == id);
+  memcpy(&id, &rdbuf[8 + 15], 4);
+  TEST_CHECK((UIO_CAN_ID_EXT | UIO_CAN_ID_RTR | 0x18FFABCD) == id);
+}
+
+static void test_can_swfilter()
+{
+  TCanMsg  hmsg;
+
+  can_restart();
+  canctrl->SwFilterClearExt();
+  memset(&canctrl->swf_std_bitmap[0], 0, sizeof(canctrl->swf_std_bitmap));
+
+  uint32_t ids[2] = {0x00000001, 0x1FFFFFFF};
+  TEST_CHECK(0 == test_udo_write(0x1817, &ids[0], sizeof(ids)));
+  uint32_t bad_id = 0x20000000;
+  TEST_CHECK(UDOERR_WRITE_VALUE == test_udo_write(0x1817, &bad_id, 4));
+
+  uint8_t  bitmap[256];
+  memset(&bitmap[0], 0, sizeof(bitmap));
+  bitmap[0x123 >> 3] |= (1 << (0x123 & 7));
+  TEST_CHECK(0 == test_udo_write(0x1816, &bitmap[0], sizeof(bitmap)));
+
+  uint32_t swf = (UIO_CAN_SWF_STD | UIO_CAN_SWF_EXT);
+  TEST_CHECK(0 == test_udo_write(0x1815, &swf, 4));
+
+  canctrl->swf_hit_cnt = 0;
+  canctrl->swf_drop_cnt = 0;
+  can_msg(&hmsg, HWCAN_EXT_FLAG | 0x00000001, 1);
+  can->InjectRx(&hmsg);
+  can_msg(&hmsg, HWCAN_EXT_FLAG | 0x1FFFFFFF, 1);
+  can->InjectRx(&hmsg);
+  can_msg(&hmsg, HWCAN_EXT_FLAG | 0x00000002, 1);
+  can->InjectRx(&hmsg);
+  can_msg(&hmsg, 0x123, 1);
+  can->InjectRx(&hmsg);
+  can_msg(&hmsg, 0x001, 1);  // the ext id 1 is not a std id 1
+  can->InjectRx(&hmsg);
+  test_run();
+
+  TEST_CHECK(3 == canctrl->mstatus.rx_cnt);
+  TEST_CHECK((3 == canctrl->swf_hit_cnt) && (2 == canctrl->swf_drop_cnt));
+
+  TUioCanMsg umsg;
+  TEST_CHECK(canctrl->RxMessage(0, &umsg) && ((UIO_CAN_ID_EXT | 1) == umsg.can_id));
+  TEST_CHECK(canctrl->RxMessage(1, &umsg) && ((UIO_CAN_ID_EXT | 0x1FFFFFFF) == umsg.can_id));
+  TEST_CHECK(canctrl->RxMessage(2, &umsg) && (0x123 == umsg.can_id));
+
+  canctrl->swf_ctrl = 0;
+}
+
+static void test_can_swfilter_full_ring()
+{
+  // a rejected frame must not overwrite the oldest unread message of a full ring
+  TCanMsg  hmsg;
+
+  can_restart();
+  TEST_CHECK(canctrl->SetRxRing(0x100, 4));
+  memset(&canctrl->swf_std_bitmap[0], 0, sizeof(canctrl->swf_std_bitmap));
+  canctrl->swf_std_bitmap[0x123 >> 5] |= (1u << (0x123 & 31));
+  canctrl->swf_ctrl = UIO_CAN_SWF_STD;
+  canctrl->swf_drop_cnt = 0;
+
+  for (unsigned n = 0; n < 4; ++n)
+  {
+    can_msg(&hmsg, 0x123, 1);
+    hmsg.data[0] = n;
+    can->InjectRx(&hmsg);
+    test_run();
+  }
+  can_msg(&hmsg, 0x124, 1);
+  can->InjectRx(&hmsg);
+  test_run();
+
+  TEST_CHECK((4 == canctrl->mstatus.rx_cnt) && (0 == canctrl->mstatus.rx_lost));
+  TEST_CHECK(1 == canctrl->swf_drop_cnt);
+
+  TUioCanMsg umsg;
+  for (unsigned n = 0; n < 4; ++n)
+  {
+    TEST_CHECK(canctrl->RxMessage(n, &umsg) && (0x123 == umsg.can_id) && (n == umsg.data[0]));
+  }
+
+  canctrl->swf_ctrl = 0;
+  canctrl->SetRxRing(0, 0);
+}
+
+static void test_can_cyclic_restart()
+{
+  // the cyclic table restarts on time after the CAN was disabled for a long time
+  can_restart();
+
+  TUioCanCycEntry * pentry = (TUioCanCycEntry *)&g_uiodev.mpram[0];
+  memset(pentry, 0, sizeof(*pentry));
+  pentry->period_us = 1000;
+  pentry->msg.can_id = 0x555;
+  pentry->msg.can_dlc = 1;
+
+  uint32_t v = 0;
+  TEST_CHECK(0 == test_udo_write(0x1810, &v, 2));
+  v = 1;
+  TEST_CHECK(0 == test_udo_write(0x1811, &v, 1));
+  TEST_CHECK(0 == test_udo_write(0x1812, &v, 1));
+
+  test_run(1000);  // 10 ms
+  TEST_CHECK((canctrl->cyc_stat[0].tx_cnt >= 9) && (canctrl->cyc_stat[0].tx_cnt <= 11));
+
+  uint32_t ctrl = (UIO_CAN_CTRL_ACTIVE << 16);
+  TEST_CHECK(0 == test_udo_write(0x1801, &ctrl, 4));
+  host_clockcnt += 20 * SystemCoreClock;  // more than the half clock counter range
+  test_run();
+  ctrl = UIO_CAN_CTRL_ACTIVE;
+  TEST_CHECK(0 == test_udo_write(0x1801, &ctrl, 4));
+
+  unsigned sent_start = can->sent_cnt;
+  test_run(1000);
+  TEST_CHECK((can->sent_cnt - sent_start >= 9) && (can->sent_cnt - sent_start <= 11));
+  TEST_CHECK(canctrl->cyc_stat[0].late_cnt < 2);
+
+  v = 0;
+  TEST_CHECK(0 == test_udo_write(0x1812, &v, 1));
+}
+
+void test_can()
+{
+  printf("CAN tests\n");
+
+  test_can_msg_conversion();
+  test_can_send();
+  test_can_xfilters();
+  test_can_swfilter();
+  test_can_swfilter_full_ring();
+  test_can_cyclic_restart();
+}
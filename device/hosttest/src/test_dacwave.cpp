@@ -0,0 +1,62 @@
+/*
+ *  file:     test_dacwave.cpp
+ *  brief:    DAC waveform double buffer update tests
+*/
+
+#include "hosttest.h"
+#include "uio_device.h"
+
+static bool dacwave_half_ok(TUioDacWave * pw, uint8_t ahalf, uint16_t aamplitude)
+{
+  // the sine peak is at the quarter period
+  uint16_t v = pw->buf[ahalf * pw->samples + pw->samples / 4];
+  int32_t  expected = g_uiodev.dac_value[0] + ((32767 * aamplitude) >> 15);
+  return (v >= expected - 1) && (v <= expected + 1);
+}
+
+static void test_dacwave_update()
+{
+  TUioDacWave * pw = &g_uiodev.dacwave[0];
+  unsigned      ns;
+
+  g_uiodev.ana_out[0] = &g_dac[0];
+  g_uiodev.dac_value[0] = 0x8000;
+  pw->amplitude = 0x4000;
+  TEST_CHECK(0 == g_uiodev.DacWaveSetType(0, UIO_DACWAVE_SINE));
+  ns = pw->samples;
+  TEST_CHECK(dacwave_half_ok(pw, 0, 0x4000) && dacwave_half_ok(pw, 1, 0x4000));
+
+  // the DMA enters the written half during the build: the update is repeated
+  pw->amplitude = 0x2000;
+  pw->update = true;
+  g_uiodev.dacwave_pos[0] = ns - 1;
+  g_uiodev.dacwave_pos_step[0] = 1;
+  g_uiodev.RunDacWaves();
+  TEST_CHECK(pw->update && (0 == pw->copyhalf));
+
+  // now in the second half: the first one is built
+  g_uiodev.RunDacWaves();
+  TEST_CHECK(!pw->update && (2 == pw->copyhalf));
+  TEST_CHECK(dacwave_half_ok(pw, 0, 0x2000));
+
+  // the DMA returns to the old half during the copy: the copy is repeated
+  g_uiodev.dacwave_pos[0] = ns - 1;
+  g_uiodev.RunDacWaves();
+  TEST_CHECK(2 == pw->copyhalf);
+
+  g_uiodev.dacwave_pos[0] = 10;
+  g_uiodev.RunDacWaves();
+  TEST_CHECK(0 == pw->copyhalf);
+  TEST_CHECK(dacwave_half_ok(pw, 0, 0x2000) && dacwave_half_ok(pw, 1, 0x2000));
+
+  g_uiodev.dacwave_pos_step[0] = 0;
+  TEST_CHECK(0 == g_uiodev.DacWaveSetType(0, UIO_DACWAVE_OFF));
+  g_uiodev.ana_out[0] = nullptr;
+}
+
+void test_dacwave()
+{
+  printf("DAC waveform tests\n");
+
+  test_dacwave_update();
+}
@@ -0,0 +1,306 @@
+/*
+ *  file:     test_nvdata.cpp
+ *  brief:    NV data store tests: legacy migration, power loss, endurance
+*/
+
+#include "stdlib.h"
+#include "new"
+#include "hosttest.h"
+#include "uio_device.h"
+#include "uio_nvdata.h"
+#include "uio_nvstorage.h"
+
+#define TEST_NVKV_IDS  40   // 0 - 31: legacy u32 values, above: 20 byte values
+
+static uint32_t  shadow[TEST_NVKV_IDS];
+
+// power-on with the actual flash contents, the power loss drops the queued flash jobs
+static void nvdata_reboot(bool apowerloss = false)
+{
+  if (apowerloss)
+  {
+    THostFlash * fl = test_nvflash();
+    fl->WaitForComplete();
+    fl->op_limit = 0;
+    g_nvstorage.~TUioNvStorage();
+    new (&g_nvstorage) TUioNvStorage();
+  }
+  else
+  {
+    g_nvstorage.WaitJobs();
+  }
+  g_nvdata.~TUioNvData();
+  new (&g_nvdata) TUioNvData();
+  g_nvdata.Init();
+}
+
+static void nvdata_write_legacy()
+{
+  THostFlash * fl = test_nvflash();
+  unsigned     addr = g_uiodev.nvsaddr_nvdata;
+
+  fl->Erase(addr, g_uiodev.nvs_nvdata_size);
+  fl->WaitForComplete();
+
+  // an older copy in the first sector, the newer one in the second
+  TUioNvDataHead head;
+  head.signature = UIO_NVDATA_SIGNATURE;
+  head.serial = 1;
+  for (unsigned n = 0; n < UIO_NVDATA_COUNT; ++n)
+  {
+    head.value[n] = n * 10 + 1;
+  }
+  fl->Write(addr, &head, sizeof(head));
+  fl->WaitForComplete();
+
+  addr += g_uiodev.nvs_sector_size;
+  head.serial = 2;
+  for (unsigned n = 0; n < UIO_NVDATA_COUNT; ++n)
+  {
+    head.value[n] = n * 10;
+  }
+  fl->Write(addr, &head, sizeof(head));
+  fl->WaitForComplete();
+
+  TUioNvDataChRec rec = {5, 5 ^ 0xFF, {0xFF, 0xFF}, 555};
+  fl->Write(addr + sizeof(head), &rec, sizeof(rec));
+  fl->WaitForComplete();
+}
+
+static bool nvdata_legacy_values_ok()
+{
+  for (unsigned n = 0; n < UIO_NVDATA_COUNT; ++n)
+  {
+    TUioNvKvKey * pkey = g_nvdata.FindKey(n);
+    uint32_t v = (5 == n ? 555 : n * 10);
+    if (!pkey || (4 != pkey->len) || (*(uint32_t *)&pkey->data[0] != v) || (g_nvdata.value[n] != v))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void test_nvdata_migration()
+{
+  nvdata_write_legacy();
+  nvdata_reboot();
+
+  TEST_CHECK(nvdata_legacy_values_ok());
+  TEST_CHECK(32 == g_nvdata.key_cnt);
+  for (unsigned n = 0; n < g_nvdata.sector_cnt; ++n)
+  {
+    TEST_CHECK(UIO_NVKV_SEC_LEGACY != g_nvdata.sec_state[n]);
+  }
+  TEST_CHECK(UIO_NVKV_SEC_FREE == g_nvdata.sec_state[1]);  // the newer legacy sector is released last
+
+  nvdata_reboot();  // the migration is not repeated
+  TEST_CHECK(nvdata_legacy_values_ok());
+}
+
+static void test_nvdata_migration_powerloss()
+{
+  // power loss after every flash operation of the migration: the next start must migrate again
+  THostFlash * fl = test_nvflash();
+  unsigned     lost_cnt = 0;
+  for (unsigned limit = 1; limit < 200; ++limit)
+  {
+    nvdata_write_legacy();
+
+    fl->op_cnt = 0;
+    fl->op_limit = limit;
+    nvdata_reboot();
+    bool lost = (fl->op_cnt > limit);
+
+    nvdata_reboot(true);
+    TEST_CHECK(nvdata_legacy_values_ok());
+    if (!lost)
+    {
+      break;  // the migration completed before the power loss
+    }
+    ++lost_cnt;
+  }
+  TEST_CHECK(lost_cnt > 32);
+}
+
+static void nvdata_random_value(unsigned aid, uint32_t avalue, uint8_t * rbuf, unsigned * rlen)
+{
+  unsigned len = (aid < UIO_NVDATA_COUNT ? 4 : 20);
+  memset(rbuf, avalue, len);
+  memcpy(rbuf, &avalue, 4);
+  *rlen = len;
+}
+
+static bool nvdata_shadow_ok()
+{
+  for (unsigned n = 0; n < TEST_NVKV_IDS; ++n)
+  {
+    uint8_t  buf[32];
+    unsigned len;
+    nvdata_random_value(n, shadow[n], &buf[0], &len);
+    TUioNvKvKey * pkey = g_nvdata.FindKey(n);
+    if (!pkey || (pkey->len != len) || (0 != memcmp(&pkey->data[0], &buf[0], len)))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void test_nvdata_endurance()
+{
+  THostFlash * fl = test_nvflash();
+  unsigned     n;
+  uint8_t      buf[32];
+  unsigned     len;
+
+  g_nvdata.lock = UIO_NVDATA_UNLOCK;
+  for (n = 0; n < TEST_NVKV_IDS; ++n)
+  {
+    shadow[n] = n;
+    nvdata_random_value(n, shadow[n], &buf[0], &len);
+    while (UDOERR_BUSY == g_nvdata.SetValue(n, &buf[0], len))
+    {
+      test_run();
+    }
+  }
+
+  fl->overwrite_cnt = 0;
+  uint32_t erase_start = fl->erase_cnt;
+  unsigned busy_cnt = 0;
+  unsigned err_cnt = 0;
+
+  srand(1);
+  for (unsigned i = 0; i < 100000; ++i)
+  {
+    unsigned id = rand() % TEST_NVKV_IDS;
+    uint32_t v  = rand();
+    nvdata_random_value(id, v, &buf[0], &len);
+    uint16_t r = g_nvdata.SetValue(id, &buf[0], len);
+    if (0 == r)
+    {
+      shadow[id] = v;
+    }
+    else if (UDOERR_BUSY == r)
+    {
+      ++busy_cnt;
+    }
+    else
+    {
+      ++err_cnt;
+    }
+    test_run();
+  }
+  g_nvdata.lock = 0;
+
+  TEST_CHECK(0 == err_cnt);
+  TEST_CHECK(busy_cnt < 10000);
+  TEST_CHECK(g_nvdata.compactions > 0);
+  TEST_CHECK(nvdata_shadow_ok());
+
+  printf("  nvdata endurance: %u erases, %u compactions, %u busy\n",
+      unsigned(fl->erase_cnt - erase_start), unsigned(g_nvdata.compactions), busy_cnt);
+
+  nvdata_reboot();
+  TEST_CHECK(nvdata_shadow_ok());
+  TEST_CHECK(0 == fl->overwrite_cnt);  // no write without erase
+
+  // the wear is spread over the sectors
+  uint32_t emin = 0xFFFFFFFF;
+  uint32_t emax = 0;
+  for (n = 0; n < g_nvdata.sector_cnt; ++n)
+  {
+    uint32_t e = g_nvdata.sec_erase_cnt[n];
+    if (e < emin)  emin = e;
+    if (e > emax)  emax = e;
+  }
+  TEST_CHECK(emax <= 2 * emin + 2);
+}
+
+static void test_nvdata_endurance_powerloss()
+{
+  // power loss in the middle of the background jobs: the store must start with consistent records
+  THostFlash * fl = test_nvflash();
+  uint8_t      buf[32];
+  unsigned     len;
+
+  srand(2);
+  for (unsigned cycle = 0; cycle < 50; ++cycle)
+  {
+    g_nvdata.lock = UIO_NVDATA_UNLOCK;
+    fl->op_cnt = 0;
+    fl->op_limit = 1 + rand() % 200;
+    for (unsigned i = 0; i < 500; ++i)
+    {
+      unsigned id = rand() % TEST_NVKV_IDS;
+      nvdata_random_value(id, rand(), &buf[0], &len);
+      g_nvdata.SetValue(id, &buf[0], len);
+      test_run();
+    }
+    g_nvdata.lock = 0;
+
+    nvdata_reboot(true);
+    unsigned found = 0;
+    for (unsigned n = 0; n < TEST_NVKV_IDS; ++n)
+    {
+      TUioNvKvKey * pkey = g_nvdata.FindKey(n);
+      if (pkey)
+      {
+        ++found;
+        nvdata_random_value(n, *(uint32_t *)&pkey->data[0], &buf[0], &len);
+        TEST_CHECK((pkey->len == len) && (0 == memcmp(&pkey->data[0], &buf[0], len)));
+      }
+    }
+    TEST_CHECK(TEST_NVKV_IDS == found);
+  }
+}
+
+static void test_nvdata_compaction_nonblocking()
+{
+  // the compaction step must not wait for the queued flash jobs (e.g. the setup save)
+  uint8_t   buf[32];
+  unsigned  len;
+  unsigned  i;
+
+  g_nvdata.lock = UIO_NVDATA_UNLOCK;
+  for (i = 0; (i < 10000) && !g_nvdata.cmp_active; ++i)
+  {
+    unsigned id = i % TEST_NVKV_IDS;
+    nvdata_random_value(id, i, &buf[0], &len);
+    g_nvdata.SetValue(id, &buf[0], len);
+    g_nvstorage.WaitJobs();
+    g_nvdata.Run();
+  }
+  g_nvdata.lock = 0;
+  TEST_CHECK(g_nvdata.cmp_active);
+
+  g_nvstorage.WaitJobs();
+  TEST_CHECK(g_nvstorage.AddJob(UIO_NVS_JOB_ERASE, g_uiodev.nvsaddr_setup, nullptr, g_uiodev.nvs_sector_size));
+  uint32_t done = g_nvstorage.jobs_done;
+  g_nvdata.Run();
+  #if HAS_SPI_FLASH
+    TEST_CHECK(g_nvstorage.Busy() && (done == g_nvstorage.jobs_done));
+  #endif
+
+  g_nvstorage.WaitJobs();
+  nvdata_reboot();
+}
+
+void test_nvdata()
+{
+  printf("nvdata tests, %u sectors of %u bytes\n", unsigned(g_uiodev.nvs_nvdata_size / g_uiodev.nvs_sector_size),
+      unsigned(g_uiodev.nvs_sector_size));
+
+  // the two sector store of the most boards
+  uint32_t nvdata_size = g_uiodev.nvs_nvdata_size;
+  g_uiodev.nvs_nvdata_size = 2 * g_uiodev.nvs_sector_size;
+  test_nvdata_migration();
+  test_nvdata_migration_powerloss();
+  g_uiodev.nvs_nvdata_size = nvdata_size;
+
+  test_nvdata_migration();
+  test_nvdata_migration_powerloss();
+  test_nvdata_endurance();
+  test_nvdata_endurance_powerloss();
+  test_nvdata_compaction_nonblocking();
+}
@@ -0,0 +1,64 @@
+/*
+ *  file:     test_nvstorage.cpp
+ *  brief:    NV storage job tests
+*/
+
+#include "hosttest.h"
+#include "uio_device.h"
+#include "uio_nvstorage.h"
+
+static uint8_t  copy_src[6000];
+
+// runs the background jobs, returns the main loop iterations
+static unsigned nvstorage_run_jobs()
+{
+  unsigned cnt = 0;
+  while (g_nvstorage.Busy() && (cnt < 100000))
+  {
+    g_nvstorage.Run();
+    ++cnt;
+  }
+  return cnt;
+}
+
+static void test_nvstorage_copy()
+{
+  // the copy job compares, erases and writes only the changed sectors, in steps
+  THostFlash * fl = test_nvflash();
+  unsigned     addr = g_uiodev.nvsaddr_setup;
+
+  for (unsigned n = 0; n < sizeof(copy_src); ++n)
+  {
+    copy_src[n] = n * 7;
+  }
+
+  TEST_CHECK(g_nvstorage.AddJob(UIO_NVS_JOB_COPY, addr, &copy_src[0], sizeof(copy_src)));
+  nvstorage_run_jobs();
+  TEST_CHECK(0 == memcmp(fl->Ptr(addr), &copy_src[0], sizeof(copy_src)));
+
+  // unchanged: no erase
+  uint32_t erase_cnt = fl->erase_cnt;
+  TEST_CHECK(g_nvstorage.AddJob(UIO_NVS_JOB_COPY, addr, &copy_src[0], sizeof(copy_src)));
+  unsigned runs = nvstorage_run_jobs();
+  TEST_CHECK(erase_cnt == fl->erase_cnt);
+  #if HAS_SPI_FLASH
+    TEST_CHECK(runs >= sizeof(copy_src) / UIO_NVS_COPY_CMPLEN);  // one compare read per Run()
+  #else
+    (void)runs;
+  #endif
+
+  // one changed byte in the second sector: only that one is erased
+  copy_src[5000] ^= 0xFF;
+  TEST_CHECK(g_nvstorage.AddJob(UIO_NVS_JOB_COPY, addr, &copy_src[0], sizeof(copy_src)));
+  nvstorage_run_jobs();
+  TEST_CHECK(0 == memcmp(fl->Ptr(addr), &copy_src[0], sizeof(copy_src)));
+  TEST_CHECK(erase_cnt + (4096 / fl->erase_size) >= fl->erase_cnt);
+  TEST_CHECK(erase_cnt < fl->erase_cnt);
+}
+
+void test_nvstorage()
+{
+  printf("nvstorage tests\n");
+
+  test_nvstorage_copy();
+}
@@ -0,0 +1,177 @@
+/*
+ *  file:     test_slcan.cpp
+ *  brief:    SLCAN command parser and frame formatting tests
+*/
+
+#include "hosttest.h"
+#include "uio_device.h"
+#include "uio_slcan.h"
+
+static TUioCanCtrl *  canctrl = &g_canctrl[0];
+static THwCan *       can = &g_can[0];
+static TUsbEndpoint * ep_in = &usb_func_slcan.uif_data.ep_input;
+
+static void slcan_run(unsigned acount = 1)
+{
+  while (acount)
+  {
+    test_run();
+    g_slcan.Run();
+    while (ep_in->tx_busy)  // the USB host takes the packets immediately
+    {
+      ep_in->tx_busy = false;
+      usb_func_slcan.uif_data.HandleTransferEvent(ep_in, false);
+    }
+    --acount;
+  }
+}
+
+// sends the command and returns the response in rresp
+static void slcan_cmd(const char * acmd, char * rresp, unsigned aresplen)
+{
+  TUsbEndpoint * ep_out = &usb_func_slcan.uif_data.ep_output;
+  unsigned len = strlen(acmd);
+  memcpy(&ep_out->rxbuf[0], acmd, len);
+  ep_out->rxlen = len;
+  ep_in->txlen = 0;
+  usb_func_slcan.uif_data.HandleTransferEvent(ep_out, true);
+  slcan_run();
+
+  unsigned rlen = (ep_in->txlen < aresplen - 1 ? ep_in->txlen : aresplen - 1);
+  memcpy(rresp, &ep_in->txbuf[0], rlen);
+  rresp[rlen] = 0;
+}
+
+static bool slcan_cmd_check(const char * acmd, const char * aresponse)
+{
+  char resp[64];
+  slcan_cmd(acmd, &resp[0], sizeof(resp));
+  if (0 != strcmp(&resp[0], aresponse))
+  {
+    printf("  SLCAN \"%s\" response: \"%s\"\n", acmd, &resp[0]);
+    return false;
+  }
+  return true;
+}
+
+static void test_slcan_commands()
+{
+  TEST_CHECK(slcan_cmd_check("C\r", "\a"));  // not opened
+  TEST_CHECK(slcan_cmd_check("S6\r", "\r"));
+  TEST_CHECK(500000 == can->speed);
+  TEST_CHECK(slcan_cmd_check("S9\r", "\a"));
+  TEST_CHECK(slcan_cmd_check("V\r", "V1013\r"));
+  TEST_CHECK(slcan_cmd_check("t1230\r", "\a"));  // not opened
+  TEST_CHECK(slcan_cmd_check("O\r", "\r"));
+  TEST_CHECK(can->Enabled() && g_slcan.opened);
+  TEST_CHECK(slcan_cmd_check("S4\r", "\a"));     // the speed can not be changed when opened
+
+  unsigned sent_start = can->sent_cnt;
+  TEST_CHECK(slcan_cmd_check("t1232AABB\r", "z\r"));
+  TEST_CHECK(slcan_cmd_check("T1ABCDE1280102030405060708\r", "Z\r"));
+  TEST_CHECK(slcan_cmd_check("r7FF0\r", "z\r"));
+  TEST_CHECK(slcan_cmd_check("R000000014\r", "Z\r"));
+  TEST_CHECK(sent_start + 4 == can->sent_cnt);
+
+  TCanMsg * pmsg = &can->sent[sent_start];
+  TEST_CHECK((0x123 == pmsg[0].cobid) && (2 == pmsg[0].len) && (0xAA == pmsg[0].data[0]) && (0xBB == pmsg[0].data[1]));
+  TEST_CHECK(((HWCAN_EXT_FLAG | 0x1ABCDE12) == pmsg[1].cobid) && (8 == pmsg[1].len) && (8 == pmsg[1].data[7]));
+  TEST_CHECK(((HWCAN_RTR_FLAG | 0x7FF) == pmsg[2].cobid) && (0 == pmsg[2].len));
+  TEST_CHECK(((HWCAN_EXT_FLAG | HWCAN_RTR_FLAG | 1) == pmsg[3].cobid) && (4 == pmsg[3].len));
+
+  // invalid frames
+  TEST_CHECK(slcan_cmd_check("t8001AA\r", "\a"));    // 11-bit id overflow
+  TEST_CHECK(slcan_cmd_check("T200000001AA\r", "\a"));  // 29-bit id overflow
+  TEST_CHECK(slcan_cmd_check("t1232AA\r", "\a"));    // short data
+  TEST_CHECK(slcan_cmd_check("t1231AABB\r", "\a"));  // long data
+  TEST_CHECK(slcan_cmd_check("t1239\r", "\a"));      // dlc > 8
+  TEST_CHECK(slcan_cmd_check("t12G0\r", "\a"));      // not hex
+  TEST_CHECK(slcan_cmd_check("T1ABCDE128010203040506070801020304\r", "\a"));  // too long
+  TEST_CHECK(sent_start + 4 == can->sent_cnt);
+
+  // more commands in one packet, the line feeds are ignored
+  TEST_CHECK(slcan_cmd_check("Z1\r\nF\r\n", "\rF00\r"));
+  TEST_CHECK(slcan_cmd_check("Z0\r", "\r"));
+}
+
+static void test_slcan_forward()
+{
+  TCanMsg  hmsg;
+  char     resp[64];
+
+  memset(&hmsg, 0, sizeof(hmsg));
+  hmsg.cobid = 0x7E8;
+  hmsg.len = 3;
+  hmsg.data[0] = 0x01;
+  hmsg.data[1] = 0xAB;
+  hmsg.data[2] = 0xFF;
+  can->InjectRx(&hmsg);
+  hmsg.cobid = HWCAN_EXT_FLAG | 0x18DAF110;
+  hmsg.len = 8;
+  can->InjectRx(&hmsg);
+  hmsg.cobid = HWCAN_EXT_FLAG | HWCAN_RTR_FLAG | 0x0000ABCD;
+  hmsg.len = 2;
+  can->InjectRx(&hmsg);
+  hmsg.cobid = HWCAN_RTR_FLAG | 0x001;
+  hmsg.len = 0;
+  can->InjectRx(&hmsg);
+
+  ep_in->txlen = 0;
+  slcan_run();
+  unsigned rlen = (ep_in->txlen < sizeof(resp) - 1 ? ep_in->txlen : sizeof(resp) - 1);
+  memcpy(&resp[0], &ep_in->txbuf[0], rlen);
+  resp[rlen] = 0;
+  TEST_CHECK(0 == strcmp(&resp[0], "t7E8301ABFF\rT18DAF110801ABFF0000000000\rR0000ABCD2\rr0010\r"));
+
+  // with timestamps: 4 hex digits before the '\r'
+  TEST_CHECK(slcan_cmd_check("Z1\r", "\r"));
+  hmsg.cobid = 0x100;
+  hmsg.len = 1;
+  can->InjectRx(&hmsg);
+  ep_in->txlen = 0;
+  slcan_run();
+  TEST_CHECK((12 == ep_in->txlen) && (0 == memcmp(&ep_in->txbuf[0], "t100101", 7)) && ('\r' == ep_in->txbuf[11]));
+  TEST_CHECK(slcan_cmd_check("Z0\r", "\r"));
+}
+
+static void test_slcan_rx_lost()
+{
+  // the SLCAN forwarding must not hide the UDO reader overruns
+  TCanMsg  hmsg;
+  uint8_t  rdbuf[64];
+  unsigned anslen;
+
+  memset(&hmsg, 0, sizeof(hmsg));
+  hmsg.cobid = 0x321;
+  hmsg.len = 0;
+
+  // UDO read of all the messages so far
+  TEST_CHECK(0 == test_udo_read(0x1808, &rdbuf[0], sizeof(rdbuf), &anslen, canctrl->mstatus.rx_cnt - 1));
+  uint32_t lost_start = canctrl->mstatus.rx_lost;
+
+  for (unsigned n = 0; n < canctrl->rxring_size + 10; ++n)
+  {
+    can->InjectRx(&hmsg);
+    slcan_run();
+  }
+
+  TEST_CHECK(lost_start + 10 == canctrl->mstatus.rx_lost);
+  TEST_CHECK(slcan_cmd_check("F\r", "F00\r"));  // the SLCAN kept up
+}
+
+void test_slcan()
+{
+  printf("SLCAN tests\n");
+
+  canctrl->SetActive(false);
+  canctrl->SetRxRing(0, 0);
+  usb_func_slcan.InitFunction();
+  g_slcan.Init(canctrl, &usb_func_slcan);
+
+  test_slcan_commands();
+  test_slcan_forward();
+  test_slcan_rx_lost();
+
+  TEST_CHECK(slcan_cmd_check("C\r", "\r"));
+  TEST_CHECK(!can->Enabled());
+}
@@ -0,0 +1,17 @@
+/*
+ *  file:     board_pins.h
+ *  brief:    host test stub of the board pins
+*/
+
+#ifndef HOSTTEST_BOARD_PINS_H_
+#define HOSTTEST_BOARD_PINS_H_
+
+#include "hwpins.h"
+#include "hwuart.h"
+#include "spiflash.h"
+
+#if HAS_SPI_FLASH
+  extern TSpiFlash  spiflash;
+#endif
+
+#endif
@@ -0,0 +1,13 @@
+/*
+ *  file:     clockcnt.h
+ *  brief:    host test stub: CPU clock counter, advanced by the tests
+*/
+
+#ifndef HOSTTEST_CLOCKCNT_H_
+#define HOSTTEST_CLOCKCNT_H_
+
+#include "platform.h"
+
+inline void clockcnt_init() { }
+
+#endif
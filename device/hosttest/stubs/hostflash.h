@@ -0,0 +1,54 @@
+/*
+ *  file:     hostflash.h
+ *  brief:    RAM backed NOR flash model for the host tests
+ *  notes:
+ *    - the erase sets the bytes to 0xFF, the write can only clear bits (like the NOR flash)
+ *    - the operations complete after some Run() calls, so the callers must really wait
+ *    - a power loss can be simulated by stopping at a given operation count
+*/
+
+#ifndef HOSTTEST_HOSTFLASH_H_
+#define HOSTTEST_HOSTFLASH_H_
+
+#include "platform.h"
+
+class THostFlash
+{
+public:
+  uint8_t *  mem = nullptr;
+  uint32_t   memaddr = 0;       // address of the first byte
+  uint32_t   memsize = 0;
+  uint32_t   erase_size = 4096;
+  bool       completed = true;
+
+  unsigned   erase_delay = 3;   // Run() calls until the operation completes
+  unsigned   write_delay = 1;
+  unsigned   delay = 0;
+
+  uint32_t   erase_cnt = 0;
+  uint32_t   write_cnt = 0;
+  uint32_t   overwrite_cnt = 0; // bits which should be set back by a write (missing erase)
+  uint32_t   op_cnt = 0;        // erase + write operations
+  uint32_t   op_limit = 0;      // != 0: the operations above this count are lost (power loss)
+  uint32_t * sector_erases = nullptr;
+
+  void       Allocate(uint32_t asize, bool alow32 = false);  // alow32: memory mapped below 4 GByte
+  uint8_t *  Ptr(uint32_t aaddr) { return mem + (aaddr - memaddr); }
+
+  void       Erase(uint32_t aaddr, uint32_t alen);
+  void       Write(uint32_t aaddr, const void * asrc, uint32_t alen);
+  void       Read(uint32_t aaddr, void * adst, uint32_t alen) { memcpy(adst, Ptr(aaddr), alen); }
+
+  void       Run()
+  {
+    if (delay)  --delay;
+    if (!delay)  completed = true;
+  }
+
+  void       WaitForComplete()
+  {
+    while (!completed)  Run();
+  }
+};
+
+#endif
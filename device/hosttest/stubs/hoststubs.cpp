@@ -0,0 +1,151 @@
+/*
+ *  file:     hoststubs.cpp
+ *  brief:    host test implementations of the simulated VIHAL hardware
+*/
+
+#include "platform.h"
+#include "hwpins.h"
+#include "hwintflash.h"
+#include "spiflash.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "sys/mman.h"
+
+unsigned           SystemCoreClock = 120000000;
+volatile uint32_t  host_clockcnt = 0;
+
+THostPort          host_ports[HOST_PORT_COUNT];
+THwPinCtrl         hwpinctrl;
+
+THwIntFlash        hwintflash;
+
+#if HAS_SPI_FLASH
+  TSpiFlash        spiflash;
+#endif
+
+void host_port_update()
+{
+  for (unsigned n = 0; n < HOST_PORT_COUNT; ++n)
+  {
+    THostPort * port = &host_ports[n];
+    port->odr = ((port->odr | port->setreg) & ~port->clrreg);
+    port->idr = port->odr;  // the outputs are read back on the inputs
+    port->setreg = 0;
+    port->clrreg = 0;
+  }
+}
+
+//-----------------------------------------------------------------------------
+// NOR flash model
+
+void THostFlash::Allocate(uint32_t asize, bool alow32)
+{
+  if (alow32)
+  {
+    // the uiocore handles the memory mapped flash addresses as 32-bit integers
+    void * p = mmap(nullptr, asize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+    if (MAP_FAILED == p)
+    {
+      printf("flash memory allocation failed\n");
+      exit(1);
+    }
+    mem = (uint8_t *)p;
+    memaddr = (uint32_t)(uintptr_t)p;
+  }
+  else
+  {
+    mem = (uint8_t *)malloc(asize);
+    memaddr = 0;
+  }
+
+  memsize = asize;
+  memset(mem, 0xFF, asize);
+  sector_erases = (uint32_t *)calloc(asize / erase_size, sizeof(uint32_t));
+}
+
+void THostFlash::Erase(uint32_t aaddr, uint32_t alen)
+{
+  // whole sectors are erased, like by the hardware
+  uint32_t addr = (aaddr & ~(erase_size - 1));
+  uint32_t end  = ((aaddr + alen + erase_size - 1) & ~(erase_size - 1));
+
+  ++op_cnt;
+  if (!op_limit || (op_cnt <= op_limit))
+  {
+    for (; addr < end; addr += erase_size)
+    {
+      memset(Ptr(addr), 0xFF, erase_size);
+      ++sector_erases[(addr - memaddr) / erase_size];
+      ++erase_cnt;
+    }
+  }
+
+  completed = false;
+  delay = erase_delay;
+}
+
+void THostFlash::Write(uint32_t aaddr, const void * asrc, uint32_t alen)
+{
+  ++op_cnt;
+  if (!op_limit || (op_cnt <= op_limit))
+  {
+    uint8_t *       dst = Ptr(aaddr);
+    const uint8_t * src = (const uint8_t *)asrc;
+    for (uint32_t n = 0; n < alen; ++n)
+    {
+      if (src[n] & ~dst[n])
+      {
+        ++overwrite_cnt;
+      }
+      dst[n] &= src[n];
+    }
+    ++write_cnt;
+  }
+
+  completed = false;
+  delay = write_delay;
+}
+
+bool THwIntFlash::Init()
+{
+  if (!mem)
+  {
+    erase_size = 2048;
+    Allocate(128 * 1024, true);
+    start_address = memaddr;
+    bytesize = memsize;
+  }
+  initialized = true;
+  return true;
+}
+
+void THwIntFlash::StartCopyMem(uint32_t aaddr, void * asrc, uint32_t alen)
+{
+  uint8_t * src = (uint8_t *)asrc;
+  for (uint32_t offs = 0; offs < alen; )
+  {
+    uint32_t len = erase_size - ((aaddr + offs) & (erase_size - 1));
+    if (len > alen - offs)  len = alen - offs;
+    if (0 != memcmp(Ptr(aaddr + offs), src + offs, len))
+    {
+      Erase(aaddr + offs, len);
+      Write(aaddr + offs, src + offs, len);
+    }
+    offs += len;
+  }
+  completed = false;
+  delay = erase_delay;
+}
+
+bool TSpiFlash::Init()
+{
+  if (!mem)
+  {
+    erase_size = 4096;
+    Allocate(1024 * 1024, false);
+    bytesize = memsize;
+  }
+  initialized = true;
+  completed = true;
+  return true;
+}
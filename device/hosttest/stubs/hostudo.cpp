@@ -0,0 +1,143 @@
+/*
+ *  file:     hostudo.cpp
+ *  brief:    host test implementation of the UDO slave helpers
+*/
+
+#include "string.h"
+#include "udoslave.h"
+#include "simple_partable.h"
+
+extern const TParamRangeDef  param_range_table[];
+
+bool udo_response_ok(TUdoRequest * udorq)  // keeps the prepared answer
+{
+  udorq->result = 0;
+  return true;
+}
+
+bool udo_response_error(TUdoRequest * udorq, uint16_t aerror)
+{
+  udorq->result = aerror;
+  if (aerror)
+  {
+    udorq->anslen = 0;
+  }
+  return (0 == aerror);
+}
+
+bool udo_response_cstring(TUdoRequest * udorq, const char * astr)
+{
+  return udo_ro_data(udorq, (void *)astr, strlen(astr));
+}
+
+bool udo_ro_data(TUdoRequest * udorq, void * adataptr, unsigned adatalen)
+{
+  if (udorq->iswrite)
+  {
+    return udo_response_error(udorq, UDOERR_READ_ONLY);
+  }
+
+  udorq->result = 0;
+  if (udorq->offset >= adatalen)
+  {
+    udorq->anslen = 0;
+    return true;
+  }
+
+  unsigned len = adatalen - udorq->offset;
+  if (len > udorq->maxanslen)  len = udorq->maxanslen;
+  memcpy(udorq->dataptr, (uint8_t *)adataptr + udorq->offset, len);
+  udorq->anslen = len;
+  return true;
+}
+
+bool udo_rw_data(TUdoRequest * udorq, void * adataptr, unsigned adatalen)
+{
+  if (!udorq->iswrite)
+  {
+    return udo_ro_data(udorq, adataptr, adatalen);
+  }
+
+  if (udorq->offset + udorq->rqlen > adatalen)
+  {
+    return udo_response_error(udorq, UDOERR_WRITE_BOUNDS);
+  }
+
+  memcpy((uint8_t *)adataptr + udorq->offset, udorq->dataptr, udorq->rqlen);
+  return udo_response_ok(udorq);
+}
+
+bool udo_rw_data_zp(TUdoRequest * udorq, void * adataptr, unsigned adatalen)
+{
+  if (udorq->iswrite && (udorq->offset + udorq->rqlen < adatalen))
+  {
+    memset((uint8_t *)adataptr + udorq->offset + udorq->rqlen, 0, adatalen - udorq->offset - udorq->rqlen);
+  }
+  return udo_rw_data(udorq, adataptr, adatalen);
+}
+
+bool udo_ro_uint(TUdoRequest * udorq, uint32_t avalue, unsigned alen)
+{
+  return udo_ro_data(udorq, &avalue, alen);  // little endian host
+}
+
+bool udo_ro_int(TUdoRequest * udorq, int32_t avalue, unsigned alen)
+{
+  return udo_ro_data(udorq, &avalue, alen);
+}
+
+bool udo_ro_f32(TUdoRequest * udorq, float avalue)
+{
+  return udo_ro_data(udorq, &avalue, sizeof(avalue));
+}
+
+uint32_t udorq_uintvalue(TUdoRequest * udorq)
+{
+  uint32_t result = 0;
+  memcpy(&result, udorq->dataptr, (udorq->rqlen < 4 ? udorq->rqlen : 4));
+  return result;
+}
+
+int32_t udorq_intvalue(TUdoRequest * udorq)
+{
+  uint32_t result = udorq_uintvalue(udorq);
+  if ((udorq->rqlen > 0) && (udorq->rqlen < 4) && (result & (1u << (8 * udorq->rqlen - 1))))
+  {
+    result |= (0xFFFFFFFFu << (8 * udorq->rqlen));  // sign extension
+  }
+  return int32_t(result);
+}
+
+float udorq_f32value(TUdoRequest * udorq)
+{
+  float result = 0;
+  memcpy(&result, udorq->dataptr, (udorq->rqlen < 4 ? udorq->rqlen : 4));
+  return result;
+}
+
+bool udoslave_handle_base_objects(TUdoRequest * udorq)
+{
+  if (0x0000 == udorq->index)
+  {
+    return udo_ro_uint(udorq, 0x66CCAA55, 4);
+  }
+  else if (0x0001 == udorq->index)
+  {
+    return udo_ro_uint(udorq, udorq->maxanslen, 4);
+  }
+  return udo_response_error(udorq, UDOERR_INDEX);
+}
+
+bool param_read_write(TUdoRequest * udorq)
+{
+  const TParamRangeDef * prdef = &param_range_table[0];
+  while (prdef->method)
+  {
+    if ((udorq->index >= prdef->range_start) && (udorq->index <= prdef->range_end))
+    {
+      return (prdef->obj->*(prdef->method))(udorq, (TParamRangeDef *)prdef);
+    }
+    ++prdef;
+  }
+  return udo_response_error(udorq, UDOERR_INDEX);
+}
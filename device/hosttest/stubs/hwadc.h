@@ -0,0 +1,23 @@
+/*
+ *  file:     hwadc.h
+ *  brief:    host test stub of the VIHAL ADC
+*/
+
+#ifndef HOSTTEST_HWADC_H_
+#define HOSTTEST_HWADC_H_
+
+#include "platform.h"
+
+class THwAdc
+{
+public:
+  bool      initialized = false;
+  int       devnum = -1;
+  unsigned  dmaalloc = 0;
+  uint16_t  value[32] = {0};  // set by the tests
+
+  bool      Init(int adevnum, uint32_t achannel_map) { devnum = adevnum; initialized = true; return true; }
+  uint16_t  ChValue(uint8_t ach) { return value[ach & 31]; }
+};
+
+#endif
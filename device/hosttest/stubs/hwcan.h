@@ -0,0 +1,173 @@
+/*
+ *  file:     hwcan.h
+ *  brief:    host test stub of the VIHAL CAN: the sent messages are collected, the received
+ *            ones are injected by the tests, the acceptance filters are applied like by the hardware
+*/
+
+#ifndef HOSTTEST_HWCAN_H_
+#define HOSTTEST_HWCAN_H_
+
+#include "platform.h"
+
+#define HWCAN_EXT_FLAG              0x80000000  // 29-bit identifier
+#define HWCAN_RTR_FLAG              0x40000000  // remote transmission request
+
+#define HWCAN_SMP_01_PERCENT_MIN    500
+#define HWCAN_SMP_01_PERCENT_MAX    950
+#define HWCAN_RJW_01_PERCENT_MAX    500
+
+#define HOST_CAN_FILTER_MAX          32
+#define HOST_CAN_SENT_MAX           256
+
+typedef struct TCanMsg
+{
+  uint32_t   cobid;
+  uint8_t    len;
+  uint8_t    _reserved[3];
+  uint32_t   timestamp;
+  uint8_t    data[8];
+//
+} TCanMsg;
+
+class THwCan
+{
+public:
+  bool       initialized = false;
+  int        devnum = -1;
+  uint32_t   speed = 1000000;
+  bool       receive_own = false;
+  bool       silent_monitor_mode = false;
+  bool       raw_timestamp = false;
+  uint16_t   smp_01_percent = 750;
+  uint16_t   rjw_01_percent = 100;
+
+  uint8_t    acterr_rx = 0;
+  uint8_t    acterr_tx = 0;
+  uint32_t   errcnt_ack = 0;
+  uint32_t   errcnt_crc = 0;
+  uint32_t   errcnt_form = 0;
+  uint32_t   errcnt_stuff = 0;
+  uint32_t   errcnt_bit0 = 0;
+  uint32_t   errcnt_bit1 = 0;
+
+  TCanMsg *  rxfifo = nullptr;
+  uint16_t   rxfifo_size = 0;
+  uint16_t   rxfifo_wridx = 0;
+  uint16_t   rxfifo_rdidx = 0;
+  TCanMsg *  txfifo = nullptr;
+  uint16_t   txfifo_size = 0;
+  uint16_t   txfifo_wridx = 0;
+  uint16_t   txfifo_rdidx = 0;
+
+  // test helpers
+  bool       enabled = false;
+  uint32_t   timestamp = 0;
+  unsigned   filter_cnt = 0;
+  uint32_t   filter_id[HOST_CAN_FILTER_MAX];
+  uint32_t   filter_mask[HOST_CAN_FILTER_MAX];
+  unsigned   sent_cnt = 0;                  // messages passed to the bus
+  TCanMsg    sent[HOST_CAN_SENT_MAX];       // the first ones
+
+  bool       Init(int adevnum, TCanMsg * arxbuf, uint16_t arxcnt, TCanMsg * atxbuf, uint16_t atxcnt)
+  {
+    devnum = adevnum;
+    rxfifo = arxbuf;
+    rxfifo_size = arxcnt;
+    txfifo = atxbuf;
+    txfifo_size = atxcnt;
+    initialized = true;
+    return true;
+  }
+
+  void       SetSpeed(uint32_t aspeed) { speed = aspeed; }
+  void       Enable()  { enabled = true; }
+  void       Disable() { enabled = false; }
+  bool       Enabled() { return enabled; }
+  bool       IsBusOff()  { return false; }
+  bool       IsWarning() { return false; }
+  uint16_t   TimeStampCounter() { return timestamp; }
+  void       UpdateErrorCounters() { }
+
+  void       AcceptListClear() { filter_cnt = 0; }
+
+  void       AcceptAdd(uint32_t acobid, uint32_t amask)  // mask 0 = accept all with the same IDE flag
+  {
+    if (filter_cnt < HOST_CAN_FILTER_MAX)
+    {
+      filter_id[filter_cnt] = acobid;
+      filter_mask[filter_cnt] = amask;
+      ++filter_cnt;
+    }
+  }
+
+  bool       Accepted(uint32_t acobid)
+  {
+    uint32_t id = (acobid & ~HWCAN_RTR_FLAG);
+    for (unsigned n = 0; n < filter_cnt; ++n)
+    {
+      if ((id & HWCAN_EXT_FLAG) != (filter_id[n] & HWCAN_EXT_FLAG))
+      {
+        continue;
+      }
+      if (((id ^ filter_id[n]) & filter_mask[n] & ~HWCAN_EXT_FLAG) == 0)
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool       InjectRx(TCanMsg * amsg)  // a message from the bus, false = filtered out or overflow
+  {
+    if (!enabled || !Accepted(amsg->cobid))
+    {
+      return false;
+    }
+    uint16_t wr = rxfifo_wridx + 1;
+    if (wr >= rxfifo_size)  wr = 0;
+    if (wr == rxfifo_rdidx)
+    {
+      return false;
+    }
+    rxfifo[rxfifo_wridx] = *amsg;
+    rxfifo[rxfifo_wridx].timestamp = timestamp;
+    rxfifo_wridx = wr;
+    return true;
+  }
+
+  void       HandleRx() { }
+
+  bool       TryRecvMessage(TCanMsg * amsg)
+  {
+    if (rxfifo_rdidx == rxfifo_wridx)
+    {
+      return false;
+    }
+    *amsg = rxfifo[rxfifo_rdidx];
+    ++rxfifo_rdidx;
+    if (rxfifo_rdidx >= rxfifo_size)  rxfifo_rdidx = 0;
+    return true;
+  }
+
+  void       StartSendMessage(TCanMsg * amsg)
+  {
+    txfifo[txfifo_wridx] = *amsg;
+    ++txfifo_wridx;
+    if (txfifo_wridx >= txfifo_size)  txfifo_wridx = 0;
+  }
+
+  void       HandleTx()  // everything is sent immediately
+  {
+    while (txfifo_rdidx != txfifo_wridx)
+    {
+      TCanMsg * pmsg = &txfifo[txfifo_rdidx];
+      if (sent_cnt < HOST_CAN_SENT_MAX)  sent[sent_cnt] = *pmsg;
+      ++sent_cnt;
+      if (receive_own)  InjectRx(pmsg);
+      ++txfifo_rdidx;
+      if (txfifo_rdidx >= txfifo_size)  txfifo_rdidx = 0;
+    }
+  }
+};
+
+#endif
@@ -0,0 +1,21 @@
+/*
+ *  file:     hwdac.h
+ *  brief:    host test stub of the VIHAL DAC channel
+*/
+
+#ifndef HOSTTEST_HWDAC_H_
+#define HOSTTEST_HWDAC_H_
+
+#include "platform.h"
+
+class THwDacChannel
+{
+public:
+  bool      initialized = false;
+  uint16_t  value = 0;
+
+  bool      Init(int adevnum, int achnum) { initialized = true; return true; }
+  void      SetTo(uint16_t avalue) { value = avalue; }
+};
+
+#endif
@@ -0,0 +1,19 @@
+/*
+ *  file:     hwdma.h
+ *  brief:    host test stub of the VIHAL DMA channel
+*/
+
+#ifndef HOSTTEST_HWDMA_H_
+#define HOSTTEST_HWDMA_H_
+
+#include "platform.h"
+
+class THwDmaChannel
+{
+public:
+  bool      initialized = false;
+
+  bool      Init(int admanum, int achannel, int arequest) { initialized = true; return true; }
+};
+
+#endif
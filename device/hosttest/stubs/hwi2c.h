@@ -0,0 +1,78 @@
+/*
+ *  file:     hwi2c.h
+ *  brief:    host test stub of the VIHAL I2C, the transactions complete at the next Run()
+*/
+
+#ifndef HOSTTEST_HWI2C_H_
+#define HOSTTEST_HWI2C_H_
+
+#include "platform.h"
+#include "hwdma.h"
+
+typedef struct TI2cTransaction
+{
+  TI2cTransaction *  next;
+  uint8_t            address;
+  bool               completed;
+  bool               iswrite;
+  uint16_t           error;
+  uint32_t           extra;
+  uint8_t *          dataptr;
+  unsigned           datalen;
+//
+} TI2cTransaction;
+
+class THwI2c
+{
+public:
+  bool               initialized = false;
+  int                devnum = -1;
+  uint32_t           speed = 100000;
+  TI2cTransaction *  curtra = nullptr;
+  TI2cTransaction *  lasttra = nullptr;
+  bool               hang = false;  // the transactions never complete (timeout tests)
+
+  bool               Init(int adevnum) { devnum = adevnum; initialized = true; return true; }
+  void               DmaAssign(bool istx, THwDmaChannel * admach) { }
+
+  void               StartRead(TI2cTransaction * atra, uint8_t adaddr, unsigned aextra, void * dstptr, unsigned len)
+  {
+    Start(atra, adaddr, aextra, dstptr, len, false);
+  }
+
+  void               StartWrite(TI2cTransaction * atra, uint8_t adaddr, unsigned aextra, void * srcptr, unsigned len)
+  {
+    Start(atra, adaddr, aextra, srcptr, len, true);
+  }
+
+  void               Run()
+  {
+    if (curtra && !hang)
+    {
+      if (!curtra->iswrite)
+      {
+        memset(curtra->dataptr, 0xA5, curtra->datalen);
+      }
+      curtra->completed = true;
+      curtra = nullptr;
+      lasttra = nullptr;
+    }
+  }
+
+protected:
+  void               Start(TI2cTransaction * atra, uint8_t adaddr, unsigned aextra, void * aptr, unsigned len, bool awrite)
+  {
+    atra->next = nullptr;
+    atra->address = adaddr;
+    atra->extra = aextra;
+    atra->dataptr = (uint8_t *)aptr;
+    atra->datalen = len;
+    atra->iswrite = awrite;
+    atra->error = 0;
+    atra->completed = false;
+    curtra = atra;
+    lasttra = atra;
+  }
+};
+
+#endif
@@ -0,0 +1,28 @@
+/*
+ *  file:     hwintflash.h
+ *  brief:    host test stub of the VIHAL internal flash, memory mapped (below 4 GByte)
+*/
+
+#ifndef HOSTTEST_HWINTFLASH_H_
+#define HOSTTEST_HWINTFLASH_H_
+
+#include "hostflash.h"
+
+class THwIntFlash : public THostFlash
+{
+public:
+  bool       initialized = false;
+  uint32_t   start_address = 0;
+  uint32_t   bytesize = 0;
+
+  bool       Init();  // allocates the memory at the first call
+  uint32_t   EraseSize(uint32_t aaddr) { return erase_size; }
+
+  void       StartEraseMem(uint32_t aaddr, uint32_t alen)             { Erase(aaddr, alen); }
+  void       StartWriteMem(uint32_t aaddr, void * asrc, uint32_t alen) { Write(aaddr, asrc, alen); }
+  void       StartCopyMem(uint32_t aaddr, void * asrc, uint32_t alen);  // erases and writes only the changed sectors
+};
+
+extern THwIntFlash hwintflash;
+
+#endif
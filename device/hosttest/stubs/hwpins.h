@@ -0,0 +1,97 @@
+/*
+ *  file:     hwpins.h
+ *  brief:    host test stub of the VIHAL GPIO pins, the ports are plain RAM registers
+*/
+
+#ifndef HOSTTEST_HWPINS_H_
+#define HOSTTEST_HWPINS_H_
+
+#include "platform.h"
+
+#define PINCFG_INPUT           0x00000000
+#define PINCFG_OUTPUT          0x00000001
+#define PINCFG_ANALOGUE        0x00000002
+#define PINCFG_OPENDRAIN       0x00000004
+#define PINCFG_PULLUP          0x00000008
+#define PINCFG_PULLDOWN        0x00000010
+#define PINCFG_GPIO_INIT_0     0x00000000
+#define PINCFG_GPIO_INIT_1     0x00000020
+#define PINCFG_AF_SHIFT        8
+#define PINCFG_AF_0            0x00000100
+
+#define PORTNUM_A              0
+#define PORTNUM_B              1
+#define PORTNUM_C              2
+
+#define HOST_PORT_COUNT        8
+
+struct THostPort
+{
+  volatile unsigned  odr;
+  volatile unsigned  idr;
+  volatile unsigned  setreg;  // written bits are set in the odr by host_port_update()
+  volatile unsigned  clrreg;
+};
+
+extern THostPort  host_ports[HOST_PORT_COUNT];
+
+void host_port_update();
+
+class THwPinCtrl
+{
+public:
+  bool PinSetup(int aportnum, int apinnum, unsigned flags) { return true; }
+};
+
+extern THwPinCtrl hwpinctrl;
+
+class TGpioPin
+{
+public:
+  int                  portnum = 0;
+  int                  pinnum = 0;
+  bool                 inverted = false;
+  unsigned             flags = 0;
+
+  volatile unsigned *  setbitptr = nullptr;
+  volatile unsigned *  clrbitptr = nullptr;
+  volatile unsigned *  getbitptr = nullptr;
+  unsigned             setbitvalue = 0;
+  unsigned             clrbitvalue = 0;
+  unsigned             getbitshift = 0;
+
+  TGpioPin() { }
+  TGpioPin(int aportnum, int apinnum, bool ainverted) { Assign(aportnum, apinnum, ainverted); }
+
+  void Assign(int aportnum, int apinnum, bool ainverted)
+  {
+    portnum = aportnum;
+    pinnum = apinnum;
+    inverted = ainverted;
+    THostPort * port = &host_ports[aportnum % HOST_PORT_COUNT];
+    setbitptr = (inverted ? &port->clrreg : &port->setreg);
+    clrbitptr = (inverted ? &port->setreg : &port->clrreg);
+    getbitptr = &port->idr;
+    setbitvalue = (1u << apinnum);
+    clrbitvalue = (1u << apinnum);
+    getbitshift = apinnum;
+  }
+
+  void Setup(unsigned aflags)
+  {
+    flags = aflags;
+    if (aflags & PINCFG_OUTPUT)
+    {
+      SetTo(aflags & PINCFG_GPIO_INIT_1 ? 1 : 0);
+    }
+  }
+
+  void Set1()                { *setbitptr = setbitvalue; host_port_update(); }
+  void Set0()                { *clrbitptr = clrbitvalue; host_port_update(); }
+  void SetTo(unsigned value) { if (value & 1) Set1(); else Set0(); }
+  void Toggle()              { SetTo(Value() ^ 1); }
+  unsigned char Value()      { return ((*getbitptr >> getbitshift) & 1) ^ (inverted ? 1 : 0); }
+  unsigned char OutValue()   { return ((host_ports[portnum % HOST_PORT_COUNT].odr >> pinnum) & 1) ^ (inverted ? 1 : 0); }
+};
+
+#endif
@@ -0,0 +1,31 @@
+/*
+ *  file:     hwpwm.h
+ *  brief:    host test stub of the VIHAL PWM channel
+*/
+
+#ifndef HOSTTEST_HWPWM_H_
+#define HOSTTEST_HWPWM_H_
+
+#include "platform.h"
+
+class THwPwmChannel
+{
+public:
+  bool      initialized = false;
+  bool      enabled = false;
+  uint32_t  frequency = 0;
+  uint32_t  periodclocks = 0;
+  uint32_t  onclocks = 0;
+
+  bool      Init(int atimernum, int achnum, int aoutnum) { initialized = true; return true; }
+  void      SetFrequency(uint32_t afrequency)
+  {
+    frequency = afrequency;
+    periodclocks = (afrequency ? SystemCoreClock / afrequency : 0);
+  }
+  void      SetOnClocks(uint32_t aclocks) { onclocks = aclocks; }
+  void      Enable()  { enabled = true; }
+  void      Disable() { enabled = false; }
+};
+
+#endif
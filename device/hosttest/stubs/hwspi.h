@@ -0,0 +1,53 @@
+/*
+ *  file:     hwspi.h
+ *  brief:    host test stub of the VIHAL SPI, the transfers complete at the next Run()
+*/
+
+#ifndef HOSTTEST_HWSPI_H_
+#define HOSTTEST_HWSPI_H_
+
+#include "platform.h"
+#include "hwpins.h"
+#include "hwdma.h"
+
+class THwSpi
+{
+public:
+  bool       initialized = false;
+  int        devnum = -1;
+  uint32_t   speed = 1000000;
+  bool       idleclk_high = false;
+  bool       datasample_late = false;
+  bool       lsb_first = false;
+  TGpioPin * manualcspin = nullptr;
+
+  bool       finished = true;
+  uint32_t   transfer_cnt = 0;
+  uint8_t    loopback_xor = 0;  // the rx data is the tx data xor this
+
+  bool       Init(int adevnum) { devnum = adevnum; initialized = true; return true; }
+  void       DmaAssign(bool istx, THwDmaChannel * admach) { }
+
+  void       StartTransfer(unsigned acmd, unsigned aaddr, unsigned aflags, unsigned alen, void * src, void * dst)
+  {
+    if (manualcspin)  manualcspin->Set0();
+    for (unsigned n = 0; n < alen; ++n)
+    {
+      uint8_t b = (src ? ((uint8_t *)src)[n] : 0);
+      if (dst)  ((uint8_t *)dst)[n] = (b ^ loopback_xor);
+    }
+    ++transfer_cnt;
+    finished = false;
+  }
+
+  void       Run()
+  {
+    if (!finished)
+    {
+      if (manualcspin)  manualcspin->Set1();
+      finished = true;
+    }
+  }
+};
+
+#endif
@@ -0,0 +1,23 @@
+/*
+ *  file:     hwuart.h
+ *  brief:    host test stub of the VIHAL UART
+*/
+
+#ifndef HOSTTEST_HWUART_H_
+#define HOSTTEST_HWUART_H_
+
+#include "platform.h"
+#include "hwdma.h"
+
+class THwUart
+{
+public:
+  bool       initialized = false;
+  int        devnum = -1;
+  unsigned   baudrate = 115200;
+
+  bool       Init(int adevnum) { devnum = adevnum; initialized = true; return true; }
+  void       DmaAssign(bool istx, THwDmaChannel * admach) { }
+};
+
+#endif
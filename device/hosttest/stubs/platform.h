@@ -0,0 +1,33 @@
+/*
+ *  file:     platform.h
+ *  brief:    host test stub of the VIHAL platform header
+ *  notes:    the VIHAL, UDO and USB headers in this directory only declare what the
+ *            uiocore uses, the hardware is simulated in hoststubs.cpp
+*/
+
+#ifndef HOSTTEST_PLATFORM_H_
+#define HOSTTEST_PLATFORM_H_
+
+#include "stdint.h"
+#include "stddef.h"
+#include "string.h"
+
+#include "board.h"
+
+extern unsigned SystemCoreClock;
+
+// CPU clock counter, advanced by the tests (VIHAL: clockcnt.h, also included by the platform)
+extern volatile uint32_t  host_clockcnt;
+
+#define CLOCKCNT  (host_clockcnt)
+
+#define __NOP()
+
+inline void mcu_disable_interrupts() { }
+inline void mcu_enable_interrupts() { }
+inline void mcu_irq_priority_set(unsigned aintnum, uint8_t apriority) { }
+inline void mcu_irq_pending_clear(unsigned aintnum) { }
+inline void mcu_irq_enable(unsigned aintnum) { }
+inline void mcu_irq_disable(unsigned aintnum) { }
+
+#endif
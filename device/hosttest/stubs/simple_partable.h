@@ -0,0 +1,40 @@
+/*
+ *  file:     simple_partable.h
+ *  brief:    host test stub of the UDO parameter range table
+*/
+
+#ifndef HOSTTEST_SIMPLE_PARTABLE_H_
+#define HOSTTEST_SIMPLE_PARTABLE_H_
+
+#include "tclass.h"
+#include "udo.h"
+
+#define PAR_INT32_CONST   1
+#define PAR_UINT8_CONST   2
+
+struct TParamRangeDef;
+
+typedef bool (TClass::*PParRangeMethod)(TUdoRequest * rq, TParamRangeDef * prdef);
+
+typedef struct TParameterDef
+{
+  uint8_t           partype;
+  void *            varptr;
+  void *            obj;
+  void *            method;
+//
+} TParameterDef;
+
+typedef struct TParamRangeDef
+{
+  uint16_t          range_start;
+  uint16_t          range_end;
+  const TParameterDef *  partable;
+  TClass *          obj;
+  PParRangeMethod   method;
+//
+} TParamRangeDef;
+
+bool param_read_write(TUdoRequest * udorq);
+
+#endif
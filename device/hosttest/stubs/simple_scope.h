@@ -0,0 +1 @@
+/* host test stub: no scope */
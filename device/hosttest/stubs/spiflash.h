@@ -0,0 +1,28 @@
+/*
+ *  file:     spiflash.h
+ *  brief:    host test stub of the VIHAL SPI flash
+*/
+
+#ifndef HOSTTEST_SPIFLASH_H_
+#define HOSTTEST_SPIFLASH_H_
+
+#include "hostflash.h"
+#include "hwspi.h"
+
+class TSpiFlash : public THostFlash
+{
+public:
+  bool       initialized = false;
+  bool       has4kerase = false;
+  uint32_t   idcode = 0x001640EF;
+  uint32_t   bytesize = 0;
+  THwSpi *   spi = nullptr;
+
+  bool       Init();  // allocates the memory at the first call
+
+  void       StartReadMem(uint32_t aaddr, void * adst, uint32_t alen)  { Read(aaddr, adst, alen); completed = false; delay = 1; }
+  void       StartEraseMem(uint32_t aaddr, uint32_t alen)             { Erase(aaddr, alen); }
+  void       StartWriteMem(uint32_t aaddr, void * asrc, uint32_t alen) { Write(aaddr, asrc, alen); }
+};
+
+#endif
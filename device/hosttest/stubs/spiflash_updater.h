@@ -0,0 +1,38 @@
+/*
+ *  file:     spiflash_updater.h
+ *  brief:    host test stub of the VIHAL SPI flash updater (blocking)
+*/
+
+#ifndef HOSTTEST_SPIFLASH_UPDATER_H_
+#define HOSTTEST_SPIFLASH_UPDATER_H_
+
+#include "spiflash.h"
+
+class TSpiFlashUpdater
+{
+public:
+  TSpiFlash *  spiflash;
+
+  TSpiFlashUpdater(TSpiFlash * aspiflash, uint8_t * abuf, unsigned abufsize) : spiflash(aspiflash) { }
+
+  bool  UpdateFlash(uint32_t aaddr, uint8_t * asrc, uint32_t alen)
+  {
+    uint32_t esize = spiflash->erase_size;
+    for (uint32_t offs = 0; offs < alen; )
+    {
+      uint32_t len = esize - ((aaddr + offs) & (esize - 1));
+      if (len > alen - offs)  len = alen - offs;
+      if (0 != memcmp(spiflash->Ptr(aaddr + offs), asrc + offs, len))
+      {
+        spiflash->Erase(aaddr + offs, len);
+        spiflash->WaitForComplete();
+        spiflash->Write(aaddr + offs, asrc + offs, len);
+        spiflash->WaitForComplete();
+      }
+      offs += len;
+    }
+    return true;
+  }
+};
+
+#endif
@@ -0,0 +1,13 @@
+/*
+ *  file:     tclass.h
+ *  brief:    host test stub of the VIHAL TClass
+*/
+
+#ifndef HOSTTEST_TCLASS_H_
+#define HOSTTEST_TCLASS_H_
+
+class TClass
+{
+};
+
+#endif
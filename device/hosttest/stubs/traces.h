@@ -0,0 +1,18 @@
+/*
+ *  file:     traces.h
+ *  brief:    host test stub: the traces are printed only with the HOSTTEST_TRACES
+*/
+
+#ifndef HOSTTEST_TRACES_H_
+#define HOSTTEST_TRACES_H_
+
+#include "stdio.h"
+
+#ifdef HOSTTEST_TRACES
+  #define TRACE(...)        { printf( __VA_ARGS__ ); }
+#else
+  #define TRACE(...)        { }
+#endif
+#define TRACE_FLUSH(...)
+
+#endif
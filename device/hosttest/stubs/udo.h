@@ -0,0 +1,40 @@
+/*
+ *  file:     udo.h
+ *  brief:    host test stub of the UDO request definitions
+*/
+
+#ifndef HOSTTEST_UDO_H_
+#define HOSTTEST_UDO_H_
+
+#include "stdint.h"
+
+#define UDOERR_CONNECTION          0x1001
+#define UDOERR_INTERNAL            0x1002
+#define UDOERR_TIMEOUT             0x1003
+#define UDOERR_NOT_IMPLEMENTED     0x2001
+#define UDOERR_INDEX               0x2002
+#define UDOERR_READ_ONLY           0x2003
+#define UDOERR_WRITE_ONLY          0x2004
+#define UDOERR_WRITE_BOUNDS        0x2005
+#define UDOERR_WRITE_VALUE         0x2006
+#define UDOERR_DATA_TOO_BIG        0x2007
+#define UDOERR_BUSY                0x2008
+
+typedef struct TUdoRequest
+{
+  uint8_t     iswrite;
+  uint8_t     metalen;
+  uint16_t    index;
+  uint32_t    offset;
+  uint32_t    metadata;
+
+  uint16_t    rqlen;      // write data length
+  uint16_t    anslen;     // response data length
+  uint16_t    maxanslen;  // response buffer size
+  uint16_t    result;     // 0 = ok, UDOERR_* otherwise
+
+  uint8_t *   dataptr;
+//
+} TUdoRequest;
+
+#endif
@@ -0,0 +1,27 @@
+/*
+ *  file:     udoslave.h
+ *  brief:    host test stub of the UDO slave helpers, implemented in hostudo.cpp
+*/
+
+#ifndef HOSTTEST_UDOSLAVE_H_
+#define HOSTTEST_UDOSLAVE_H_
+
+#include "udo.h"
+
+bool     udo_response_ok(TUdoRequest * udorq);
+bool     udo_response_error(TUdoRequest * udorq, uint16_t aerror);  // 0 = ok
+bool     udo_response_cstring(TUdoRequest * udorq, const char * astr);
+bool     udo_ro_data(TUdoRequest * udorq, void * adataptr, unsigned adatalen);
+bool     udo_rw_data(TUdoRequest * udorq, void * adataptr, unsigned adatalen);
+bool     udo_rw_data_zp(TUdoRequest * udorq, void * adataptr, unsigned adatalen);  // zero padded write
+bool     udo_ro_uint(TUdoRequest * udorq, uint32_t avalue, unsigned alen);
+bool     udo_ro_int(TUdoRequest * udorq, int32_t avalue, unsigned alen);
+bool     udo_ro_f32(TUdoRequest * udorq, float avalue);
+uint32_t udorq_uintvalue(TUdoRequest * udorq);
+int32_t  udorq_intvalue(TUdoRequest * udorq);
+float    udorq_f32value(TUdoRequest * udorq);
+
+bool     udoslave_handle_base_objects(TUdoRequest * udorq);
+bool     udoslave_app_read_write(TUdoRequest * udorq);
+
+#endif
@@ -0,0 +1,102 @@
+/*
+ *  file:     usbdevice.h
+ *  brief:    host test stub of the VIHAL USB device stack, the endpoints are plain buffers
+*/
+
+#ifndef HOSTTEST_USBDEVICE_H_
+#define HOSTTEST_USBDEVICE_H_
+
+#include "platform.h"
+
+#define HOST_USB_EPBUF_SIZE  4096
+
+class TUsbInterface;
+
+class TUsbEndpoint
+{
+public:
+  TUsbInterface *  interface = nullptr;
+  bool             htod = false;
+
+  // host -> device data, filled by the tests
+  uint8_t          rxbuf[HOST_USB_EPBUF_SIZE];
+  unsigned         rxlen = 0;
+  bool             recv_enabled = true;
+
+  // device -> host data, collected for the tests
+  uint8_t          txbuf[HOST_USB_EPBUF_SIZE];
+  unsigned         txlen = 0;
+  bool             tx_busy = false;
+  unsigned         tx_packets = 0;
+
+  int              ReadRecvData(void * buf, uint32_t buflen)
+  {
+    unsigned len = (rxlen < buflen ? rxlen : buflen);
+    memcpy(buf, &rxbuf[0], len);
+    memmove(&rxbuf[0], &rxbuf[len], rxlen - len);
+    rxlen -= len;
+    return len;
+  }
+
+  void             EnableRecv() { recv_enabled = true; }
+
+  int              StartSendData(void * buf, unsigned len)
+  {
+    if (txlen + len <= sizeof(txbuf))
+    {
+      memcpy(&txbuf[txlen], buf, len);
+      txlen += len;
+    }
+    ++tx_packets;
+    tx_busy = true;
+    return len;
+  }
+};
+
+class TUsbInterface
+{
+public:
+  const char *     interface_name = "";
+  TUsbEndpoint     ep_input;   // device -> host
+  TUsbEndpoint     ep_output;  // host -> device
+
+  virtual          ~TUsbInterface() { }
+  virtual bool     InitInterface() { return true; }
+  virtual bool     HandleTransferEvent(TUsbEndpoint * aep, bool htod) { return false; }
+};
+
+typedef struct
+{
+  uint8_t          interface_class;
+  uint8_t          interface_subclass;
+  uint8_t          interface_protocol;
+//
+} TUsbFuncDesc;
+
+#define HOST_USB_MAX_INTERFACES  4
+
+class TUsbFunction
+{
+public:
+  const char *     func_name = "";
+  TUsbFuncDesc     funcdesc = {0, 0, 0};
+  TUsbInterface *  interfaces[HOST_USB_MAX_INTERFACES];
+  unsigned         interface_count = 0;
+
+  virtual          ~TUsbFunction() { }
+  virtual bool     InitFunction() { return true; }
+
+  void             AddInterface(TUsbInterface * aif)
+  {
+    if (interface_count < HOST_USB_MAX_INTERFACES)  interfaces[interface_count++] = aif;
+  }
+};
+
+class TUsbDevice
+{
+public:
+  virtual          ~TUsbDevice() { }
+  void             AddFunction(TUsbFunction * afunc) { afunc->InitFunction(); }
+};
+
+#endif
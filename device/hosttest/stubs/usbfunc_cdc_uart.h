@@ -0,0 +1,22 @@
+/*
+ *  file:     usbfunc_cdc_uart.h
+ *  brief:    host test stub of the VIHAL USB to UART bridge function
+*/
+
+#ifndef HOSTTEST_USBFUNC_CDC_UART_H_
+#define HOSTTEST_USBFUNC_CDC_UART_H_
+
+#include "usbif_cdc.h"
+#include "hwuart.h"
+
+class TUsbFuncCdcUart : public TUsbFunction
+{
+public:
+  TUsbCdcControl   uif_control;
+  TUsbCdcData      uif_data;
+  THwUart *        uart = nullptr;
+
+  void             AssignUart(THwUart * auart) { uart = auart; }
+};
+
+#endif
@@ -0,0 +1,21 @@
+/*
+ *  file:     usbif_cdc.h
+ *  brief:    host test stub of the VIHAL USB CDC interfaces
+*/
+
+#ifndef HOSTTEST_USBIF_CDC_H_
+#define HOSTTEST_USBIF_CDC_H_
+
+#include "usbdevice.h"
+
+class TUsbCdcData : public TUsbInterface
+{
+};
+
+class TUsbCdcControl : public TUsbInterface
+{
+public:
+  TUsbCdcData *    dataif = nullptr;
+};
+
+#endif
@@ -108,9 +108,13 @@ extern "C" __attribute__((noreturn)) void _start(unsigned self_flashing)  // sel
   mcu_enable_interrupts();
 
   g_uiodev.Init();
-  g_uiodev.LoadSetup();
+  g_uiodev.LoadSetup();  // the USB descriptors need the cfg
 
+  // start the USB first, the host needs some time until the first request anyway
   usb_app_init();
+  g_uiodev.BootStamp(UIO_BOOTST_USB);
+
+  g_uiodev.ActivateSetup();
 
   TRACE("\r\nStarting main cycle...\r\n");
 
@@ -27,11 +27,17 @@
 
 #include <udoslaveapp.h>
 #include "paramtable.h"
+#include "uio_device.h"
 
 // the udoslave_app_read_write() is called from the communication system (Serial or IP) to
 // handle the actual UDO requests
 bool udoslave_app_read_write(TUdoRequest * udorq)
 {
+  if (0 == g_uiodev.boot_clocks[UIO_BOOTST_FIRST_RQ])
+  {
+    g_uiodev.BootStamp(UIO_BOOTST_FIRST_RQ);
+  }
+
   if (udorq->index < 0x0100)  // handle the standard UDO indexes (0x0000 - 0x00FF)
   {
     return udoslave_handle_base_objects(udorq);
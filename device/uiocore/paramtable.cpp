@@ -64,7 +64,7 @@ const TParamRangeDef  param_range_table[] =
   {0x0200, 0x02FF, nullptr, &g_uiodev, PParRangeMethod(&TUioDevice::prfn_PinConfig) },
 
   // output default values
-  {0x0300, 0x0300, nullptr, &g_uiodev, PParRangeMethod(&TUioDevice::prfn_DefValue_DigOut) },
+  {0x0300, 0x0301, nullptr, &g_uiodev, PParRangeMethod(&TUioDevice::prfn_DefValue_DigOut) },
   {0x0320, 0x033F, nullptr, &g_uiodev, PParRangeMethod(&TUioDevice::prfn_DefValue_AnaOut) },
   {0x0340, 0x035F, nullptr, &g_uiodev, PParRangeMethod(&TUioDevice::prfn_DefValue_PwmDuty) },
   {0x0360, 0x037F, nullptr, &g_uiodev, PParRangeMethod(&TUioDevice::prfn_DefValue_LedBlp) },
@@ -76,9 +76,10 @@ const TParamRangeDef  param_range_table[] =
   {0x0F00, 0x0FFF, nullptr, &g_uiodev, PParRangeMethod(&TUioDevice::prfn_NvData) },
 
   // IO Access
-  {0x1000, 0x1001, nullptr, &g_uiodev, PParRangeMethod(&TUioDevice::prfn_DigOutSetClr) },
-  {0x1010, 0x1010, nullptr, &g_uiodev, PParRangeMethod(&TUioDevice::prfn_DigOutDirect) },
-  {0x1100, 0x1100, nullptr, &g_uiodev, PParRangeMethod(&TUioDevice::prfn_DigInValues) },
+  {0x1000, 0x1003, nullptr, &g_uiodev, PParRangeMethod(&TUioDevice::prfn_DigOutSetClr) },
+  {0x1010, 0x1012, nullptr, &g_uiodev, PParRangeMethod(&TUioDevice::prfn_DigOutDirect) },
+  {0x1100, 0x1102, nullptr, &g_uiodev, PParRangeMethod(&TUioDevice::prfn_DigInValues) },
+  {0x1180, 0x11CF, nullptr, &g_uiodev, PParRangeMethod(&TUioDevice::prfn_CounterCtrl) },
   {0x1200, 0x12FF, nullptr, &g_uiodev, PParRangeMethod(&TUioDevice::prfn_AnaInValues) },
   {0x1300, 0x13FF, nullptr, &g_uiodev, PParRangeMethod(&TUioDevice::prfn_AnaOutCtrl) },
   {0x1400, 0x14FF, nullptr, &g_uiodev, PParRangeMethod(&TUioDevice::prfn_PwmControl) },
@@ -104,10 +105,10 @@ const TParamRangeDef  param_range_table[] =
 	#endif
 
   #if UIO_CAN_COUNT > 0
-    {0x1800, 0x180F, nullptr, &g_canctrl[0], PParRangeMethod(&TUioCanCtrl::prfn_CanControl) },
+    {0x1800, 0x181F, nullptr, &g_canctrl[0], PParRangeMethod(&TUioCanCtrl::prfn_CanControl) },
   #endif
   #if UIO_CAN_COUNT > 1
-    {0x1820, 0x182F, nullptr, &g_canctrl[1], PParRangeMethod(&TUioCanCtrl::prfn_CanControl) },
+    {0x1820, 0x183F, nullptr, &g_canctrl[1], PParRangeMethod(&TUioCanCtrl::prfn_CanControl) },
   #endif
 
   // MPRAM
@@ -28,17 +28,49 @@
 
 #include "uio_can_control.h"
 #include "uio_dev_base.h"
+#include "clockcnt.h"
+#include "string.h"
 
 THwCan       g_can[UIO_CAN_COUNT];
 TUioCanCtrl  g_canctrl[UIO_CAN_COUNT];
 
+// The extended frames require a VIHAL CAN driver which carries the IDE flag in the cobid
+#ifdef HWCAN_EXT_FLAG
+  #define UIO_CAN_EXT_SUPPORTED  1
+#else
+  #define UIO_CAN_EXT_SUPPORTED  0
+#endif
+
+#ifdef HWCAN_RTR_FLAG
+  #define UIO_CAN_RTR_SUPPORTED  1
+#else
+  #define UIO_CAN_RTR_SUPPORTED  0
+#endif
+
+// Frame length in bits without the stuff bits and the interframe space
+static inline unsigned can_frame_bits(TCanMsg * amsg)
+{
+  unsigned dbits = 8 * amsg->len;
+  #if UIO_CAN_RTR_SUPPORTED
+    if (amsg->cobid & HWCAN_RTR_FLAG)  dbits = 0;
+  #endif
+  #if UIO_CAN_EXT_SUPPORTED
+    if (amsg->cobid & HWCAN_EXT_FLAG)  return 67 + dbits;
+  #endif
+  return 47 + dbits;
+}
+
 void TUioCanCtrl::Init(TUioDevBase * adevbase, THwCan * acan)
 {
   devbase = adevbase;
   can = acan;
   mstatus.rx_cnt = 0;
   mstatus.tx_cnt = 0;
-  rxbuf_filled = false;
+  SetRxRing(0, 0);
+  ResetStats();
+
+  memset(&swf_std_bitmap[0], 0, sizeof(swf_std_bitmap));
+  SwFilterClearExt();
 }
 
 
@@ -46,28 +78,106 @@ void TUioCanCtrl::Run()
 {
   if (can->Enabled())
   {
+    TCanMsg  rxmsg;
+
     can->HandleRx();
-    unsigned rxidx = (mstatus.rx_cnt % UIO_CAN_RXBUF_SIZE);
-    while (can->TryRecvMessage(&rxbuf[rxidx]))
+    while (can->TryRecvMessage(&rxmsg))
     {
+      load_bits += can_frame_bits(&rxmsg);
+
+      if (swf_ctrl && !SwFilterAccept(&rxmsg))
+      {
+        continue;  // the ring is not touched
+      }
+
+      if (mstatus.rx_cnt - rx_read_cnt >= rxring_size)
+      {
+        ++mstatus.rx_lost;  // the oldest unread message is overwritten
+      }
+
+      rxring[rx_widx] = rxmsg;
       ++mstatus.rx_cnt;
-      ++rxidx;
-      if (rxidx >= UIO_CAN_RXBUF_SIZE)
+      ++rx_widx;
+      if (rx_widx >= rxring_size)
       {
-        rxidx = 0;
+        rx_widx = 0;
+        rxbuf_filled = true;
       }
     }
 
-    if (mstatus.rx_cnt >= UIO_CAN_RXBUF_SIZE)
+    if (cyc_active)
     {
-      rxbuf_filled = true;
+      RunCyclic();
     }
 
     can->HandleTx();
+    UpdateTxStats();
     can->UpdateErrorCounters();  // to count the CAN bus errors
   }
 }
 
+void TUioCanCtrl::QueueTx(TCanMsg * amsg)
+{
+  // the VIHAL tx queue index of this message
+  tx_stamp[can->txfifo_wridx % UIO_CAN_TXSTAMP_COUNT] = CLOCKCNT;
+  can->StartSendMessage(amsg);
+  ++mstatus.tx_cnt;
+
+  if (!can->receive_own)  // the own messages are counted at the receive otherwise
+  {
+    load_bits += can_frame_bits(amsg);
+  }
+}
+
+void TUioCanCtrl::UpdateTxStats()
+{
+  unsigned t = CLOCKCNT;
+
+  // messages passed to the CAN hardware since the last call
+  uint16_t rdidx = can->txfifo_rdidx;
+  while (txq_rdidx != rdidx)
+  {
+    unsigned lat = t - tx_stamp[txq_rdidx % UIO_CAN_TXSTAMP_COUNT];
+    if (lat > txlat_max_clocks)  txlat_max_clocks = lat;
+    txlat_avg_clocks_x16 += lat - (txlat_avg_clocks_x16 >> 4);
+
+    ++txq_rdidx;
+    if (txq_rdidx >= can->txfifo_size)  txq_rdidx = 0;
+  }
+
+  unsigned depth = (can->txfifo_wridx + can->txfifo_size - rdidx) % can->txfifo_size;
+  mstatus.txq_depth = depth;
+  if (depth > mstatus.txq_highwater)  mstatus.txq_highwater = depth;
+
+  // bus load window
+  unsigned elapsed = t - load_start;
+  if (elapsed >= (SystemCoreClock / 1000) * UIO_CAN_LOAD_WINDOW_MS)
+  {
+    if (can->speed)
+    {
+      uint64_t bus_bits = (uint64_t(can->speed) * elapsed) / SystemCoreClock;
+      unsigned load = (bus_bits ? (uint64_t(load_bits) * 1000) / bus_bits : 0);
+      if (load > 1000)  load = 1000;
+      mstatus.busload = load;
+      if (load > mstatus.busload_peak)  mstatus.busload_peak = load;
+    }
+    load_bits = 0;
+    load_start = t;
+  }
+}
+
+void TUioCanCtrl::ResetStats()
+{
+  load_bits = 0;
+  load_start = CLOCKCNT;
+  txq_rdidx = can->txfifo_rdidx;
+  txlat_avg_clocks_x16 = 0;
+  txlat_max_clocks = 0;
+  mstatus.busload = 0;
+  mstatus.busload_peak = 0;
+  mstatus.txq_highwater = 0;
+}
+
 bool TUioCanCtrl::prfn_CanControl(TUdoRequest * rq, TParamRangeDef * prdef)
 {
   uint8_t idx  = (rq->index & 0x1F);
@@ -130,15 +240,7 @@ bool TUioCanCtrl::prfn_CanControl(TUdoRequest * rq, TParamRangeDef * prdef)
 
     can->receive_own = recvown;
     can->silent_monitor_mode = silent_monitor;
-    if (active && !can->Enabled())
-    {
-      SetFilters();
-      can->Enable();
-    }
-    else if (!active && can->Enabled())
-    {
-      can->Disable();
-    }
+    SetActive(active);
 
     return udo_response_ok(rq);
   }
@@ -173,6 +275,7 @@ bool TUioCanCtrl::prfn_CanControl(TUdoRequest * rq, TParamRangeDef * prdef)
       can->errcnt_stuff = 0;
       can->errcnt_bit0 = 0;
       can->errcnt_bit1 = 0;
+      ResetStats();
       return udo_response_ok(rq);
     }
     else
@@ -187,19 +290,25 @@ bool TUioCanCtrl::prfn_CanControl(TUdoRequest * rq, TParamRangeDef * prdef)
       return udo_response_error(rq, UDOERR_WRITE_ONLY);
     }
 
-    unsigned remaining = rq->rqlen;
+    TCanMsg msg;
     TUioCanMsg * pmsg = (TUioCanMsg *)rq->dataptr;
     TUioCanMsg * pmsg_end = (TUioCanMsg *)(rq->dataptr + rq->rqlen - sizeof(TUioCanMsg));
+
+    // check all the messages first, so a rejected request sends nothing
     while (pmsg <= pmsg_end)
     {
-    	// convert to VIHAL CAN message format
-      TCanMsg msg;
-      msg.cobid = (pmsg->can_id & 0x7FF);
-      msg.len   = pmsg->can_dlc;
-      msg.timestamp = 0;
-      *(uint32_t *)&msg.data[0] = *(uint32_t *)&pmsg->data[0];
-      *(uint32_t *)&msg.data[4] = *(uint32_t *)&pmsg->data[4];
-      can->StartSendMessage(&msg);
+      if (!MsgToHw(pmsg, &msg))
+      {
+        return udo_response_error(rq, UDOERR_WRITE_VALUE);
+      }
+      ++pmsg;
+    }
+
+    pmsg = (TUioCanMsg *)rq->dataptr;
+    while (pmsg <= pmsg_end)
+    {
+      MsgToHw(pmsg, &msg);  // convert to VIHAL CAN message format
+      QueueTx(&msg);
       ++pmsg;
     }
 
@@ -207,7 +316,7 @@ bool TUioCanCtrl::prfn_CanControl(TUdoRequest * rq, TParamRangeDef * prdef)
   }
   else if (0x06 == idx) // CAN Rx Buffer Size
   {
-    return udo_ro_uint(rq, UIO_CAN_RXBUF_SIZE,  4);
+    return udo_ro_uint(rq, rxring_size,  4);
   }
   else if (0x07 == idx) // CAN Rx Status
   {
@@ -215,75 +324,7 @@ bool TUioCanCtrl::prfn_CanControl(TUdoRequest * rq, TParamRangeDef * prdef)
   }
   else if (0x08 == idx) // CAN Read Received Messages
   {
-    if (rq->iswrite)
-    {
-      return udo_response_error(rq, UDOERR_READ_ONLY);
-    }
-
-    if (rq->maxanslen < 4 + sizeof(TCanMsg))
-    {
-      return udo_response_error(rq, UDOERR_DATA_TOO_BIG);
-    }
-
-    // Answer format:
-    //   u32         rxcnt;
-    //   u32         start_rxcnt;
-    //   TUioCanMsg  msg[];
-
-    uint32_t * pact_rxcnt   = (uint32_t *)(rq->dataptr + 0);
-    uint32_t * pstart_rxcnt = (uint32_t *)(rq->dataptr + 4);
-    *pact_rxcnt = mstatus.rx_cnt;
-    rq->anslen = 8;
-
-    TUioCanMsg *  pomsg = (TUioCanMsg *)(rq->dataptr + 8);
-
-    int msgcnt = mstatus.rx_cnt - rq->offset;  // count of new messages to send
-    if (msgcnt <= 0)
-    {
-      // the provided offset was higher than the actual message count, report the last
-      // rxcnt with no messages
-      *pstart_rxcnt = mstatus.rx_cnt;
-      return udo_response_ok(rq);
-    }
-
-    // else msgcnt > 0
-
-    if (msgcnt > UIO_CAN_RXBUF_SIZE)
-    {
-      msgcnt = UIO_CAN_RXBUF_SIZE; // some messages are lost in this case
-    }
-
-    uint32_t startcnt = mstatus.rx_cnt - msgcnt;
-    *pstart_rxcnt = startcnt;
-    uint32_t maxmsg = (rq->maxanslen - rq->anslen) / sizeof(TCanMsg);
-    if (msgcnt > maxmsg)
-    {
-      msgcnt = maxmsg;  // not all the new messages fit into the answer buffer
-    }
-
-    unsigned midx = (startcnt % UIO_CAN_RXBUF_SIZE);
-    while (msgcnt)
-    {
-      TCanMsg * imsg = &rxbuf[midx];
-
-      pomsg->can_id  = imsg->cobid;
-      pomsg->can_dlc = imsg->len;
-      pomsg->__pad   = 0;
-      pomsg->timestamp = imsg->timestamp;
-      *(uint32_t *)&pomsg->data[0] = *(uint32_t *)&imsg->data[0];
-      *(uint32_t *)&pomsg->data[4] = *(uint32_t *)&imsg->data[4];
-      ++pomsg;
-      ++midx;
-      if (midx >= UIO_CAN_RXBUF_SIZE)
-      {
-        midx = 0;
-      }
-
-      rq->anslen += sizeof(TCanMsg);
-      --msgcnt;
-    }
-
-    return udo_response_ok(rq);
+    return RxRead(rq, false);
   }
   else if (0x09 == idx) // Sampling point position in 0.1%
   {
@@ -321,18 +362,434 @@ bool TUioCanCtrl::prfn_CanControl(TUdoRequest * rq, TParamRangeDef * prdef)
       return udo_ro_int(rq, can->rjw_01_percent, 4);
     }
   }
+  else if (0x0B == idx) // CAN Extended ID Filters
+  {
+    if (!udo_rw_data(rq, &xfilters[0], sizeof(xfilters)))
+    {
+      return false;
+    }
+
+    if (rq->iswrite)
+    {
+      if ((xfilters[0] > UIO_CAN_XFILTER_MAX) || (xfilters[0] && !UIO_CAN_EXT_SUPPORTED))
+      {
+        xfilters[0] = 0;
+        return udo_response_error(rq, UDOERR_WRITE_VALUE);
+      }
+
+      if (can->Enabled())
+      {
+        can->Disable();
+        SetFilters();
+        can->Enable();
+      }
+    }
 
+    return true;
+  }
+  else if (0x0C == idx) // CAN Read Received Messages, packed
+  {
+    return RxRead(rq, true);
+  }
+  else if (0x0D == idx) // CAN Rx ring MPRAM offset
+  {
+    if (rq->iswrite && can->Enabled())
+    {
+      return udo_response_error(rq, UDOERR_BUSY);
+    }
+    return udo_rw_data(rq, &rxring_offs, sizeof(rxring_offs));
+  }
+  else if (0x0E == idx) // CAN Rx ring size in the MPRAM in messages, 0 = internal buffer
+  {
+    if (rq->iswrite)
+    {
+      if (can->Enabled())
+      {
+        return udo_response_error(rq, UDOERR_BUSY);
+      }
+      uint32_t v = udorq_uintvalue(rq);
+      if (!SetRxRing(rxring_offs, v))
+      {
+        return udo_response_error(rq, UDOERR_WRITE_VALUE);
+      }
+      return udo_response_ok(rq);
+    }
+    return udo_ro_uint(rq, (rxring == &rxbuf[0] ? 0 : rxring_size), 4);
+  }
+  else if (0x10 == idx) // Cyclic Tx table MPRAM offset
+  {
+    if (rq->iswrite && cyc_active)
+    {
+      return udo_response_error(rq, UDOERR_BUSY);
+    }
+    return udo_rw_data(rq, &cyc_offs, sizeof(cyc_offs));
+  }
+  else if (0x11 == idx) // Cyclic Tx table entry count
+  {
+    if (rq->iswrite)
+    {
+      if (cyc_active)
+      {
+        return udo_response_error(rq, UDOERR_BUSY);
+      }
+      uint32_t v = udorq_uintvalue(rq);
+      if (v > UIO_CAN_CYC_MAX)
+      {
+        return udo_response_error(rq, UDOERR_WRITE_VALUE);
+      }
+      cyc_cnt = v;
+      return udo_response_ok(rq);
+    }
+    return udo_ro_uint(rq, cyc_cnt, 1);
+  }
+  else if (0x12 == idx) // Cyclic Tx start (1) / stop (0)
+  {
+    if (rq->iswrite)
+    {
+      if (udorq_uintvalue(rq))
+      {
+        if (!CyclicStart())
+        {
+          return udo_response_error(rq, UDOERR_WRITE_VALUE);
+        }
+      }
+      else
+      {
+        cyc_active = false;
+      }
+      return udo_response_ok(rq);
+    }
+    return udo_ro_uint(rq, (cyc_active ? 1 : 0), 1);
+  }
+  else if (0x13 == idx) // Cyclic Tx statistics: TUioCanCycStat[cyc_cnt]
+  {
+    return udo_ro_data(rq, &cyc_stat[0], cyc_cnt * sizeof(TUioCanCycStat));
+  }
+  else if (0x14 == idx) // Cyclic Tx maximal delay in us, write resets
+  {
+    if (rq->iswrite)
+    {
+      cyc_max_delay_us = 0;
+      return udo_response_ok(rq);
+    }
+    return udo_ro_uint(rq, cyc_max_delay_us, 4);
+  }
+  else if (0x15 == idx) // Software filter control: bit0 = 11-bit bitmap, bit1 = 29-bit hash set
+  {
+    if (rq->iswrite)
+    {
+      uint32_t v = udorq_uintvalue(rq);
+      if ((v & ~(UIO_CAN_SWF_STD | UIO_CAN_SWF_EXT)) || ((v & UIO_CAN_SWF_EXT) && !UIO_CAN_EXT_SUPPORTED))
+      {
+        return udo_response_error(rq, UDOERR_WRITE_VALUE);
+      }
+      swf_ctrl = v;
+      return udo_response_ok(rq);
+    }
+    return udo_ro_uint(rq, swf_ctrl, 1);
+  }
+  else if (0x16 == idx) // Software filter 11-bit id bitmap (256 bytes, bit n = accept id n)
+  {
+    return udo_rw_data(rq, &swf_std_bitmap[0], sizeof(swf_std_bitmap));
+  }
+  else if (0x17 == idx) // Software filter 29-bit id set: write adds ids (u32 array), read = count
+  {
+    if (rq->iswrite)
+    {
+      uint32_t * pid  = (uint32_t *)rq->dataptr;
+      uint32_t * pend = (uint32_t *)(rq->dataptr + (rq->rqlen & ~3));
+      while (pid < pend)
+      {
+        if (!SwFilterAddExt(*pid))
+        {
+          return udo_response_error(rq, UDOERR_WRITE_VALUE);  // full or invalid id
+        }
+        ++pid;
+      }
+      return udo_response_ok(rq);
+    }
+    return udo_ro_uint(rq, swf_ext_cnt, 2);
+  }
+  else if (0x18 == idx) // Software filter 29-bit id set clear
+  {
+    if (!rq->iswrite)
+    {
+      return udo_response_error(rq, UDOERR_WRITE_ONLY);
+    }
+    SwFilterClearExt();
+    return udo_response_ok(rq);
+  }
+  else if (0x19 == idx) // Software filter statistics: u32 hit, u32 drop, write resets
+  {
+    if (rq->iswrite)
+    {
+      swf_hit_cnt = 0;
+      swf_drop_cnt = 0;
+      return udo_response_ok(rq);
+    }
+    uint32_t stat[2] = {swf_hit_cnt, swf_drop_cnt};
+    return udo_ro_data(rq, &stat[0], sizeof(stat));
+  }
 
   return udo_response_error(rq, UDOERR_INDEX);
 }
 
+bool TUioCanCtrl::CyclicStart()
+{
+  TCanMsg msg;
+
+  cyc_active = false;
+  if ((0 == cyc_cnt) || (cyc_offs & 3) || (cyc_offs + cyc_cnt * sizeof(TUioCanCycEntry) > UIO_MPRAM_SIZE))
+  {
+    return false;
+  }
+
+  TUioCanCycEntry * pentry = (TUioCanCycEntry *)&devbase->mpram[cyc_offs];
+  for (unsigned n = 0; n < cyc_cnt; ++n)
+  {
+    if (pentry->period_us && ((pentry->period_us < 100) || (pentry->period_us > 10000000)
+                              || (pentry->phase_us > 10000000) || !MsgToHw(&pentry->msg, &msg)))
+    {
+      return false;
+    }
+    ++pentry;
+  }
+
+  unsigned clocks_per_us = SystemCoreClock / 1000000;
+  unsigned t = CLOCKCNT;
+  pentry = (TUioCanCycEntry *)&devbase->mpram[cyc_offs];
+  for (unsigned n = 0; n < cyc_cnt; ++n)
+  {
+    cyc_next_time[n] = t + pentry->phase_us * clocks_per_us;
+    ++pentry;
+  }
+
+  memset(&cyc_stat[0], 0, sizeof(cyc_stat));
+  cyc_max_delay_us = 0;
+  cyc_active = true;
+  return true;
+}
+
+void TUioCanCtrl::RunCyclic()
+{
+  // The host writes the table with single MPRAM requests, which are processed in the same main loop,
+  // so a payload is never sent half updated.
+
+  TCanMsg  msg;
+  unsigned clocks_per_us = SystemCoreClock / 1000000;
+  unsigned t = CLOCKCNT;
+  TUioCanCycEntry * pentry = (TUioCanCycEntry *)&devbase->mpram[cyc_offs];
+  for (unsigned n = 0; n < cyc_cnt; ++n, ++pentry)
+  {
+    uint32_t period = pentry->period_us;
+    if ((0 == period) || (int(t - cyc_next_time[n]) < 0))
+    {
+      continue;
+    }
+
+    unsigned period_clocks = period * clocks_per_us;
+    unsigned delay = t - cyc_next_time[n];
+    if (delay >= period_clocks)  // one or more periods were missed
+    {
+      cyc_stat[n].late_cnt += delay / period_clocks;
+      cyc_next_time[n] = t;
+    }
+    cyc_next_time[n] += period_clocks;
+
+    uint32_t delay_us = delay / clocks_per_us;
+    if (delay_us > cyc_max_delay_us)
+    {
+      cyc_max_delay_us = delay_us;
+    }
+
+    if (MsgToHw(&pentry->msg, &msg))  // the payload might be changed to invalid in the meantime
+    {
+      QueueTx(&msg);
+      ++cyc_stat[n].tx_cnt;
+    }
+  }
+}
+
+void TUioCanCtrl::SetActive(bool aactive)
+{
+  if (aactive && !can->Enabled())
+  {
+    SetFilters();
+    can->Enable();
+    ResetStats();
+
+    if (cyc_active)
+    {
+      CyclicStart();  // re-base the schedule, the clock could wrap around during the inactive time
+    }
+  }
+  else if (!aactive && can->Enabled())
+  {
+    can->Disable();
+  }
+}
+
+bool TUioCanCtrl::SendMessage(TUioCanMsg * amsg)
+{
+  TCanMsg msg;
+  if (!MsgToHw(amsg, &msg))
+  {
+    return false;
+  }
+  QueueTx(&msg);
+  return true;
+}
+
+bool TUioCanCtrl::RxMessage(uint32_t arxcnt, TUioCanMsg * amsg)
+{
+  uint32_t back = mstatus.rx_cnt - arxcnt;
+  if ((0 == back) || (back > rxring_size))
+  {
+    return false;  // not received yet or already overwritten
+  }
+
+  unsigned midx = rx_widx + rxring_size - back;
+  if (midx >= rxring_size)  midx -= rxring_size;
+  MsgFromHw(&rxring[midx], amsg);
+  return true;
+}
+
+void TUioCanCtrl::RxConsumed(uint32_t arxcnt)
+{
+  if (int(arxcnt - rx_read_cnt) > 0)
+  {
+    rx_read_cnt = arxcnt;
+  }
+}
+
+bool TUioCanCtrl::SetRxRing(uint32_t aoffs, uint32_t acount)
+{
+  if (0 == acount)
+  {
+    rxring = &rxbuf[0];
+    rxring_size = UIO_CAN_RXBUF_SIZE;
+  }
+  else
+  {
+    if ((acount < 2) || (aoffs & 7) || (aoffs + acount * sizeof(TCanMsg) > UIO_MPRAM_SIZE))
+    {
+      return false;
+    }
+    rxring = (TCanMsg *)&devbase->mpram[aoffs];
+    rxring_size = acount;
+  }
+
+  // restart the receive counting
+  mstatus.rx_cnt = 0;
+  mstatus.rx_lost = 0;
+  rx_read_cnt = 0;
+  rx_widx = 0;
+  rxbuf_filled = false;
+  return true;
+}
+
+bool TUioCanCtrl::RxRead(TUdoRequest * rq, bool apacked)
+{
+  if (rq->iswrite)
+  {
+    return udo_response_error(rq, UDOERR_READ_ONLY);
+  }
+
+  if (rq->maxanslen < 8 + sizeof(TUioCanMsg))
+  {
+    return udo_response_error(rq, UDOERR_DATA_TOO_BIG);
+  }
+
+  // Answer format:
+  //   u32         rxcnt;
+  //   u32         start_rxcnt;
+  //   TUioCanMsg  msg[];
+  // Packed format messages (7 + dlc bytes, RTR frames have no data):
+  //   u32         can_id;
+  //   u16         timestamp;
+  //   u8          dlc;
+  //   u8          data[dlc];
+
+  uint32_t * pact_rxcnt   = (uint32_t *)(rq->dataptr + 0);
+  uint32_t * pstart_rxcnt = (uint32_t *)(rq->dataptr + 4);
+  *pact_rxcnt = mstatus.rx_cnt;
+  rq->anslen = 8;
+
+  uint32_t msgcnt = mstatus.rx_cnt - rq->offset;  // count of new messages to send
+  if ((0 == msgcnt) || (msgcnt > 0x80000000))
+  {
+    // the provided offset was higher than the actual message count, report the last
+    // rxcnt with no messages
+    *pstart_rxcnt = mstatus.rx_cnt;
+    return udo_response_ok(rq);
+  }
+
+  if (msgcnt > rxring_size)
+  {
+    msgcnt = rxring_size; // some messages are lost in this case, counted at the receive
+  }
+
+  uint32_t startcnt = mstatus.rx_cnt - msgcnt;
+  *pstart_rxcnt = startcnt;
+
+  TUioCanMsg    umsg;
+  uint8_t *     dp     = (rq->dataptr + 8);
+  uint8_t *     endptr = (rq->dataptr + rq->maxanslen);
+  unsigned      midx   = (rx_widx + rxring_size - msgcnt);
+  if (midx >= rxring_size)  midx -= rxring_size;
+
+  while (msgcnt)
+  {
+    MsgFromHw(&rxring[midx], &umsg);
+    if (apacked)
+    {
+      unsigned dlen = ((umsg.can_id & UIO_CAN_ID_RTR) ? 0 : umsg.can_dlc);
+      if (dp + 7 + dlen > endptr)
+      {
+        break;
+      }
+      memcpy(dp, &umsg.can_id, 4);
+      memcpy(dp + 4, &umsg.timestamp, 2);
+      dp[6] = umsg.can_dlc;
+      memcpy(dp + 7, &umsg.data[0], dlen);
+      dp += 7 + dlen;
+    }
+    else
+    {
+      if (dp + sizeof(TUioCanMsg) > endptr)
+      {
+        break;  // not all the new messages fit into the answer buffer
+      }
+      memcpy(dp, &umsg, sizeof(TUioCanMsg));
+      dp += sizeof(TUioCanMsg);
+    }
+
+    ++midx;
+    if (midx >= rxring_size)
+    {
+      midx = 0;
+    }
+    ++startcnt;
+    --msgcnt;
+  }
+
+  rq->anslen = dp - rq->dataptr;
+  RxConsumed(startcnt);  // the host has these messages
+
+  return udo_response_ok(rq);
+}
+
 void TUioCanCtrl::SetFilters()
 {
   can->AcceptListClear();
-  unsigned fnum = filters[0];
-  if (0 == fnum)
+  unsigned fnum  = filters[0];
+  unsigned xfnum = (UIO_CAN_EXT_SUPPORTED ? xfilters[0] : 0);
+  if ((0 == fnum) && (0 == xfnum))
   {
     can->AcceptAdd(0x000, 0x000);
+    #if UIO_CAN_EXT_SUPPORTED
+      can->AcceptAdd(HWCAN_EXT_FLAG, 0x000);
+    #endif
   }
   else
   {
@@ -341,7 +798,169 @@ void TUioCanCtrl::SetFilters()
     {
       can->AcceptAdd(filters[n] & 0xFFFF, filters[n] >> 16);
     }
+
+    #if UIO_CAN_EXT_SUPPORTED
+      if (xfnum > UIO_CAN_XFILTER_MAX) xfnum = UIO_CAN_XFILTER_MAX;
+      for (unsigned n = 0; n < xfnum; ++n)
+      {
+        can->AcceptAdd(HWCAN_EXT_FLAG | (xfilters[1 + 2 * n] & UIO_CAN_ID_MASK_EXT),
+                       xfilters[2 + 2 * n] & UIO_CAN_ID_MASK_EXT);
+      }
+    #endif
+  }
+}
+
+bool TUioCanCtrl::MsgToHw(TUioCanMsg * pmsg, TCanMsg * hmsg)
+{
+  if (pmsg->can_dlc > 8)
+  {
+    return false;
+  }
+
+  uint32_t cobid;
+  if (pmsg->can_id & UIO_CAN_ID_EXT)
+  {
+    #if UIO_CAN_EXT_SUPPORTED
+      cobid = HWCAN_EXT_FLAG | (pmsg->can_id & UIO_CAN_ID_MASK_EXT);
+    #else
+      return false;
+    #endif
+  }
+  else
+  {
+    cobid = (pmsg->can_id & UIO_CAN_ID_MASK_STD);
+  }
+
+  if (pmsg->can_id & UIO_CAN_ID_RTR)
+  {
+    #if UIO_CAN_RTR_SUPPORTED
+      cobid |= HWCAN_RTR_FLAG;
+    #else
+      return false;
+    #endif
+  }
+
+  hmsg->cobid = cobid;
+  hmsg->len   = pmsg->can_dlc;
+  hmsg->timestamp = 0;
+  *(uint32_t *)&hmsg->data[0] = *(uint32_t *)&pmsg->data[0];
+  *(uint32_t *)&hmsg->data[4] = *(uint32_t *)&pmsg->data[4];
+  return true;
+}
+
+void TUioCanCtrl::MsgFromHw(TCanMsg * hmsg, TUioCanMsg * pmsg)
+{
+  uint32_t canid;
+  #if UIO_CAN_EXT_SUPPORTED
+    if (hmsg->cobid & HWCAN_EXT_FLAG)
+    {
+      canid = UIO_CAN_ID_EXT | (hmsg->cobid & UIO_CAN_ID_MASK_EXT);
+    }
+    else
+  #endif
+  {
+    canid = (hmsg->cobid & UIO_CAN_ID_MASK_STD);
+  }
+
+  #if UIO_CAN_RTR_SUPPORTED
+    if (hmsg->cobid & HWCAN_RTR_FLAG)
+    {
+      canid |= UIO_CAN_ID_RTR;
+    }
+  #endif
+
+  pmsg->can_id  = canid;
+  pmsg->can_dlc = hmsg->len;
+  pmsg->__pad   = 0;
+  pmsg->timestamp = hmsg->timestamp;
+  *(uint32_t *)&pmsg->data[0] = *(uint32_t *)&hmsg->data[0];
+  *(uint32_t *)&pmsg->data[4] = *(uint32_t *)&hmsg->data[4];
+}
+
+static inline unsigned swf_hash(uint32_t aid)
+{
+  return ((aid * 2654435761u) >> 16) & (UIO_CAN_SWF_HASH_SIZE - 1);  // multiplicative hashing
+}
+
+bool TUioCanCtrl::SwFilterAccept(TCanMsg * hmsg)
+{
+  bool accept;
+
+  #if UIO_CAN_EXT_SUPPORTED
+    if (hmsg->cobid & HWCAN_EXT_FLAG)
+    {
+      if (0 == (swf_ctrl & UIO_CAN_SWF_EXT))
+      {
+        return true;  // only the hardware filters apply
+      }
+
+      uint32_t id = (hmsg->cobid & UIO_CAN_ID_MASK_EXT);
+      unsigned h = swf_hash(id);
+      accept = false;
+      while (swf_ext_hash[h] != UIO_CAN_SWF_HASH_EMPTY)  // the table is never full
+      {
+        if (swf_ext_hash[h] == id)
+        {
+          accept = true;
+          break;
+        }
+        h = ((h + 1) & (UIO_CAN_SWF_HASH_SIZE - 1));
+      }
+    }
+    else
+  #endif
+  {
+    if (0 == (swf_ctrl & UIO_CAN_SWF_STD))
+    {
+      return true;
+    }
+
+    uint32_t id = (hmsg->cobid & UIO_CAN_ID_MASK_STD);
+    accept = (0 != (swf_std_bitmap[id >> 5] & (1 << (id & 31))));
+  }
+
+  if (accept)
+  {
+    ++swf_hit_cnt;
+  }
+  else
+  {
+    ++swf_drop_cnt;
+  }
+  return accept;
+}
+
+bool TUioCanCtrl::SwFilterAddExt(uint32_t aid)
+{
+  if (aid > UIO_CAN_ID_MASK_EXT)
+  {
+    return false;
+  }
+
+  unsigned h = swf_hash(aid);
+  while (swf_ext_hash[h] != UIO_CAN_SWF_HASH_EMPTY)
+  {
+    if (swf_ext_hash[h] == aid)
+    {
+      return true;  // already present
+    }
+    h = ((h + 1) & (UIO_CAN_SWF_HASH_SIZE - 1));
+  }
+
+  if (swf_ext_cnt >= UIO_CAN_SWF_HASH_MAX)  // keep free slots for short probe sequences
+  {
+    return false;
   }
+
+  swf_ext_hash[h] = aid;
+  ++swf_ext_cnt;
+  return true;
+}
+
+void TUioCanCtrl::SwFilterClearExt()
+{
+  memset(&swf_ext_hash[0], 0xFF, sizeof(swf_ext_hash));
+  swf_ext_cnt = 0;
 }
 
 void TUioCanCtrl::UpdateStatus()
@@ -367,4 +986,9 @@ void TUioCanCtrl::UpdateStatus()
   mstatus.errcnt_stuff = can->errcnt_stuff;
   mstatus.errcnt_bit0  = can->errcnt_bit0;
   mstatus.errcnt_bit1  = can->errcnt_bit1;
+
+  // the busload and the tx queue depth are updated in the Run()
+  unsigned clocks_per_us = SystemCoreClock / 1000000;
+  mstatus.txlat_avg_us = (txlat_avg_clocks_x16 >> 4) / clocks_per_us;
+  mstatus.txlat_max_us = txlat_max_clocks / clocks_per_us;
 }
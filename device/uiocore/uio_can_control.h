@@ -42,6 +42,31 @@
 #define UIO_CAN_CTRL_RECVOWN    (1 << 1)
 #define UIO_CAN_CTRL_SILENTM    (1 << 2)   // silent monitor mode
 
+// TUioCanMsg.can_id flags, the identifier is in the lower 29 bits
+#define UIO_CAN_ID_EXT          (1u << 31)  // 29-bit extended identifier
+#define UIO_CAN_ID_RTR          (1u << 30)  // remote transmission request
+#define UIO_CAN_ID_MASK_STD     0x000007FF
+#define UIO_CAN_ID_MASK_EXT     0x1FFFFFFF
+
+#define UIO_CAN_XFILTER_MAX     4
+
+// second-stage software acceptance filter
+#define UIO_CAN_SWF_STD         (1 << 0)   // 11-bit ids: bitmap
+#define UIO_CAN_SWF_EXT         (1 << 1)   // 29-bit ids: hash set
+
+#ifndef UIO_CAN_SWF_HASH_SIZE
+  #define UIO_CAN_SWF_HASH_SIZE   256      // must be power of 2
+#endif
+#define UIO_CAN_SWF_HASH_MAX    (UIO_CAN_SWF_HASH_SIZE * 3 / 4)
+#define UIO_CAN_SWF_HASH_EMPTY  0xFFFFFFFF
+
+#define UIO_CAN_LOAD_WINDOW_MS  100
+#define UIO_CAN_TXSTAMP_COUNT   64   // must be >= the VIHAL tx queue size
+
+#ifndef UIO_CAN_CYC_MAX
+  #define UIO_CAN_CYC_MAX       16
+#endif
+
 #define UIO_CAN_ST_ERR_PASSIVE  (1 << 0)
 #define UIO_CAN_ST_ERR_BUSOFF   (1 << 1)
 
@@ -53,7 +78,7 @@ class TUioDevBase;
 
 typedef struct
 {
-  uint32_t   can_id;
+  uint32_t   can_id;      // bit31: extended id, bit30: RTR
   uint8_t    can_dlc;
   uint8_t    __pad;
   uint16_t   timestamp;   // in CAN bit-clocks
@@ -62,6 +87,21 @@ typedef struct
 //
 } TUioCanMsg; // 16 Bytes
 
+typedef struct
+{
+  uint32_t    period_us;  // 0 = entry disabled
+  uint32_t    phase_us;   // delay of the first transmission after the start
+  TUioCanMsg  msg;        // the timestamp is ignored, the payload can be updated any time
+//
+} TUioCanCycEntry; // 24 bytes
+
+typedef struct
+{
+  uint32_t    tx_cnt;     // transmissions of the entry
+  uint32_t    late_cnt;   // missed periods
+//
+} TUioCanCycStat;
+
 typedef struct
 {
   uint8_t   status;       // actual status flags
@@ -80,8 +120,16 @@ typedef struct
 
   uint32_t  rx_cnt;       // CAN messages received since the start
   uint32_t  tx_cnt;       // CAN messages transmitted (queued) since the start
+  uint32_t  rx_lost;      // CAN messages overwritten in the rx ring before the host read them
+
+  uint16_t  busload;      // bus load of the last window in 0.1%, from the frame bit lengths
+  uint16_t  busload_peak; // highest window bus load since the counter reset
+  uint16_t  txq_depth;    // messages waiting in the tx queue
+  uint16_t  txq_highwater;
+  uint32_t  txlat_avg_us; // queue to transmit latency, average (exponential)
+  uint32_t  txlat_max_us;
 //
-} TCanCtrlStatus; // 40 bytes
+} TCanCtrlStatus; // 60 bytes
 
 
 class TUioCanCtrl : public TClass
@@ -94,17 +142,66 @@ public:
   TCanCtrlStatus    mstatus;
 
   uint32_t          filters[8] = {0};
+  uint32_t          xfilters[1 + 2 * UIO_CAN_XFILTER_MAX] = {0};  // count, then (id, mask) pairs
 
   void              Init(TUioDevBase * adevbase, THwCan * acan);
   void              Run();
   bool              prfn_CanControl(TUdoRequest * rq, TParamRangeDef * prdef);
 
+  void              SetActive(bool aactive);
+  bool              SendMessage(TUioCanMsg * amsg);
+  bool              RxMessage(uint32_t arxcnt, TUioCanMsg * amsg);  // from the rx ring by the receive counter
+  void              RxConsumed(uint32_t arxcnt);  // UDO read position, only for the rx_lost counting
   void              SetFilters();
+  bool              SetRxRing(uint32_t aoffs, uint32_t acount);
+  bool              RxRead(TUdoRequest * rq, bool apacked);
+  bool              MsgToHw(TUioCanMsg * pmsg, TCanMsg * hmsg);
+
+  bool              CyclicStart();
+  void              RunCyclic();
+
+  bool              SwFilterAccept(TCanMsg * hmsg);
+  bool              SwFilterAddExt(uint32_t aid);
+  void              SwFilterClearExt();
+  void              MsgFromHw(TCanMsg * hmsg, TUioCanMsg * pmsg);
   void              UpdateStatus();
+  void              QueueTx(TCanMsg * amsg);
+  void              UpdateTxStats();
+  void              ResetStats();
+
+public: // cyclic transmit table in the MPRAM
+  uint16_t          cyc_offs = 0;
+  uint8_t           cyc_cnt = 0;
+  bool              cyc_active = false;
+  uint32_t          cyc_max_delay_us = 0;  // the worst transmission delay
+  unsigned          cyc_next_time[UIO_CAN_CYC_MAX];
+  TUioCanCycStat    cyc_stat[UIO_CAN_CYC_MAX];
+
+public: // bus load and tx latency statistics
+  uint32_t          load_bits = 0;        // frame bits in the actual window
+  unsigned          load_start = 0;
+  uint16_t          txq_rdidx = 0;        // the last seen tx queue read index
+  unsigned          txlat_avg_clocks_x16 = 0;
+  unsigned          txlat_max_clocks = 0;
+  unsigned          tx_stamp[UIO_CAN_TXSTAMP_COUNT];  // queueing time by tx queue index
+
+public: // software acceptance filter, applied before the rxbuf
+  uint8_t           swf_ctrl = 0;
+  uint16_t          swf_ext_cnt = 0;
+  uint32_t          swf_hit_cnt = 0;
+  uint32_t          swf_drop_cnt = 0;
+  uint32_t          swf_std_bitmap[2048 / 32];
+  uint32_t          swf_ext_hash[UIO_CAN_SWF_HASH_SIZE];
 
 public:
 
-  TCanMsg           rxbuf[UIO_CAN_RXBUF_SIZE];
+  TCanMsg           rxbuf[UIO_CAN_RXBUF_SIZE];  // default rx ring
+
+  TCanMsg *         rxring = nullptr;      // rxbuf or MPRAM
+  uint32_t          rxring_size = 0;
+  uint16_t          rxring_offs = 0;
+  unsigned          rx_widx = 0;
+  uint32_t          rx_read_cnt = 0;       // the host has read the messages until this rx_cnt
 };
 
 extern THwCan       g_can[UIO_CAN_COUNT];
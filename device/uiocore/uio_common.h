@@ -46,6 +46,10 @@
   #define UIO_CAN_COUNT   0
 #endif
 
+#ifndef UIO_SLCAN_ENABLE
+  #define UIO_SLCAN_ENABLE  0
+#endif
+
 #ifndef UIO_SPIFLASH_COUNT
   #define UIO_SPIFLASH_COUNT  0
 #endif
@@ -10,13 +10,53 @@
 
 
 #define UIO_VERSION_MAJOR       3
-#define UIO_VERSION_MINOR       3
+#define UIO_VERSION_MINOR       4
 #define UIO_VERSION_INCREMENT   0
 
 #define UIO_VERSION_INTEGER  ((UIO_VERSION_MAJOR << 24) | (UIO_VERSION_MINOR << 16) | UIO_VERSION_INCREMENT)
 
 /* VERSION LOG
 
+3.4.0
+  - Pulse counter / frequency inputs (PINTYPE 12), objects at 1180-11CF
+  - Port-grouped DIN / DOUT access: one GPIO register access per port
+  - Full 64 channel DIN / DOUT: objects 1002-1003, 1011-1012, 1101-1102, 0301
+  - Timer interrupt driven LED blink patterns with bit period (1520) and phase (1540) objects,
+    main loop cycle time statistics at 0120-0122
+  - PWM single pulse mode: trigger 1420, delay 1440, width 1460, count 1480, tick frequency 14A0,
+    only on a timer without other PWM channels
+  - DAC waveform generator: type 1320, amplitude 1340, frequency 1360, user table 1380, 1390
+  - SPI descriptor chain: start with 1602 = 2, list offset 1606, count 1607, executed 1608
+  - WS2812 LED stripe encoder: start with 1602 = 3, source 160A, count 160B, format 160C
+  - SPI streaming into MPRAM ring: start with 1602 = 4, stop with 1602 = 0 (idle after the running frame), objects 1610-1615
+    the frames are paced from the main loop, minimal period: 500 us
+  - I2C script mode: offset 1705, count 1706, start / result 1707, step index 1708
+  - I2C periodic polling of the script into ping-pong MPRAM slots, objects 1710-1715,
+    slot size: 4 + data length rounded up to 4 bytes
+  - I2C re-init only on speed change or after errors, transaction timeout, bus recovery,
+    statistics at 1718-1719
+  - SPI device profiles: active profile 1618, profiles 1619-161C, additional CS pins with pin flag,
+    re-init count 161D
+  - CAN 29-bit extended identifiers and RTR flag in the message can_id (bit31, bit30),
+    extended id filters at 180B
+  - CAN cyclic transmit table in the MPRAM: offset 1810, count 1811, start/stop 1812,
+    statistics 1813-1814
+  - CAN software acceptance filter: control 1815, 11-bit bitmap 1816, 29-bit id set 1817-1818,
+    hit / drop counters 1819
+  - CAN rx ring in the MPRAM: offset 180D, size 180E, lost message counter in the status,
+    packed message read at 180C
+  - CAN status extended with bus load, peak load, tx queue depth, high-water mark and tx latency
+  - SLCAN (LAWICEL) USB CDC function for the first CAN (UIO_SLCAN_ENABLE)
+  - SPI Flash Write Accelerator: up to 15 slots (7 with 32 kByte MPRAM), slot index at command
+    bits 16-19, 16 bit free slot bitmap at 1680, CRC32 write verify, slot results at 1684,
+    slot count at 1685
+  - SPI Flash sector CRC32 list: command 4 with sector count, status 1686, CRC32 list 1687
+  - SPI Flash streaming read into the MPRAM slots 0 and 1: command 5, status 1688, ack 1689
+  - Non-blocking NV writes (NV data, setup save) through a job queue, status at 0F81
+  - NV data as log-structured key / value store over N sectors with background compaction,
+    the legacy format is migrated, wear counters 0F82, status 0F83, values by id at 0F84
+  - Single pass pin configuration at startup, activated after the USB init,
+    boot phase time stamps in us at 0130
 3.3.0
   - Added supporting custom PINTYPES (PINTYPE >= 128)
 3.2.1
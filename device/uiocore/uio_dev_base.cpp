@@ -27,6 +27,8 @@
 
 #include <uio_dev_base.h>
 #include "string.h"
+#include "stddef.h"
+#include "math.h"
 #include "hwspi.h"
 #include "hwi2c.h"
 #include "uio_nvdata.h"
@@ -63,6 +65,8 @@ bool TUioDevBase::Init()
 {
   initialized = false;
 
+  BootStamp(UIO_BOOTST_INIT);
+
   // initialize configuration defaults
   cfg.usb_vendor_id = 0xDEAD;
   cfg.usb_product_id = 0xBEEF;
@@ -88,7 +92,24 @@ bool TUioDevBase::InitDevice()
 
   g_nvstorage.Init();
 
-  blp_bit_clocks = (SystemCoreClock >> 4);  // 1/16 s
+  blp_tick_clocks = SystemCoreClock / UIO_BLP_TICK_HZ;
+  for (n = 0; n < UIO_LEDBLP_COUNT; ++n)
+  {
+    blp_period_us[n] = UIO_BLP_DEF_PERIOD;
+    LedBlpRestart(n);
+  }
+
+#if UIO_DACWAVE_COUNT
+  for (n = 0; n < UIO_DACWAVE_COUNT; ++n)
+  {
+    dacwave[n].type = UIO_DACWAVE_OFF;
+    dacwave[n].active = false;
+    dacwave[n].amplitude = 0x7FFF;
+    dacwave[n].frequency = 1000;
+    dacwave[n].user_offs = 0;
+    dacwave[n].user_len = 0;
+  }
+#endif
 
   for (n = 0; n < UIO_UART_COUNT; ++n)  uart[n] = &g_uart[n];
 
@@ -114,9 +135,17 @@ bool TUioDevBase::InitDevice()
     return false;
   }
 
+  BootStamp(UIO_BOOTST_BOARD);
+
   g_nvdata.Init();
 
-  ResetConfig();
+  BootStamp(UIO_BOOTST_NVDATA);
+
+  // the pins are configured only once, by the ActivateSetup() after the LoadSetup()
+  ClearConfig();
+
+  blp_timer_active = StartBlpTimer();
+  last_blp_time = CLOCKCNT;
 
   return true;
 }
@@ -159,11 +188,16 @@ uint16_t TUioDevBase::PinSetup(uint8_t pinid, uint32_t pincfg, bool active)
   }
 
   pcf.pintype = pintype;
+  if ((UIO_PINTYPE_SPI == pintype) && (pincfg & UIO_PINFLAG_SPI_CS))
+  {
+    pcf.pintype = UIO_PINTYPE_DIG_OUT;  // additional CS pins can be any digital output
+  }
   if (!PinFuncAvailable(&pcf))
   {
     __NOP();
     return UIOERR_FUNC_NOT_AVAIL;
   }
+  pcf.pintype = pintype;
 
   if (UIO_PINTYPE_PASSIVE == pintype) // passive = input with pullup
   {
@@ -195,7 +229,50 @@ uint16_t TUioDevBase::PinSetup(uint8_t pinid, uint32_t pincfg, bool active)
       pcf.hwpinflags |= PINCFG_PULLUP;
     }
 
-    cfginfo[UIO_INFOIDX_DIN] |= (uint64_t(1) << unitnum);
+    if (unitnum < 32)
+    {
+      cfginfo[UIO_INFOIDX_DIN] |= (1u << unitnum);
+    }
+    else
+    {
+      cfginfo[UIO_INFOIDX_DIN_32] |= (1 << (unitnum - 32));
+    }
+  }
+
+  else if (UIO_PINTYPE_COUNTER == pintype) // pulse counter / frequency input
+  {
+    if (unitnum >= UIO_CNT_COUNT)
+    {
+      return UIOERR_UNITSEL;
+    }
+
+    pcf.hwpinflags = PINCFG_INPUT;
+    if (0x0001 & pcf.flags)
+    {
+      pcf.hwpinflags |= PINCFG_PULLDOWN;
+    }
+    else if (0x0002 & pcf.flags)
+    {
+      // nothing = floating
+    }
+    else
+    {
+      pcf.hwpinflags |= PINCFG_PULLUP;
+    }
+
+    if (active)
+    {
+      TUioCntState * pst = &cnt_state[unitnum];
+      pst->hwmask = SetupCounter(&pcf);  // adds the timer alternate function to the hwpinflags
+      if (!pst->hwmask)
+      {
+        return UIOERR_UNIT_INIT;
+      }
+      pst->last_raw = CounterHwValue(unitnum);
+      SetCounterValue(unitnum, 0);
+    }
+
+    cfginfo[UIO_INFOIDX_CNT] |= (1u << unitnum);
   }
 
   else if (UIO_PINTYPE_ADC_IN == pintype)
@@ -207,7 +284,7 @@ uint16_t TUioDevBase::PinSetup(uint8_t pinid, uint32_t pincfg, bool active)
 
     SetupAdc(&pcf);
 
-    cfginfo[UIO_INFOIDX_ADC] |= (1 << unitnum);
+    cfginfo[UIO_INFOIDX_ADC] |= (1u << unitnum);
   }
 
   // OUTPUTS
@@ -226,7 +303,7 @@ uint16_t TUioDevBase::PinSetup(uint8_t pinid, uint32_t pincfg, bool active)
       ledblp[unitnum] = ppin;
       initial_1 = (0 != (ledblp_value[unitnum] & 1));
 
-      cfginfo[UIO_INFOIDX_LEDBLP] |= (1 << unitnum);
+      cfginfo[UIO_INFOIDX_LEDBLP] |= (1u << unitnum);
     }
     else
     {
@@ -236,9 +313,16 @@ uint16_t TUioDevBase::PinSetup(uint8_t pinid, uint32_t pincfg, bool active)
       }
 
       dig_out[unitnum] = ppin;
-      initial_1 = (0 != (dout_value & (1 << unitnum)));
+      initial_1 = (0 != (dout_value & (uint64_t(1) << unitnum)));
 
-      cfginfo[UIO_INFOIDX_DOUT] |= (uint64_t(1) << unitnum);
+      if (unitnum < 32)
+      {
+        cfginfo[UIO_INFOIDX_DOUT] |= (1u << unitnum);
+      }
+      else
+      {
+        cfginfo[UIO_INFOIDX_DOUT_32] |= (1 << (unitnum - 32));
+      }
     }
 
     pcf.hwpinflags = PINCFG_OUTPUT | PINCFG_GPIO_INIT_0;
@@ -282,7 +366,7 @@ uint16_t TUioDevBase::PinSetup(uint8_t pinid, uint32_t pincfg, bool active)
       SetDacOutput(unitnum, dac_value[unitnum]);  // set the default output !
     }
 
-    cfginfo[UIO_INFOIDX_DAC] |= (1 << unitnum);
+    cfginfo[UIO_INFOIDX_DAC] |= (1u << unitnum);
   }
   else if (UIO_PINTYPE_PWM_OUT == pintype)
   {
@@ -303,12 +387,17 @@ uint16_t TUioDevBase::PinSetup(uint8_t pinid, uint32_t pincfg, bool active)
       pwm->Enable();
     }
 
-    cfginfo[UIO_INFOIDX_PWM] |= (1 << unitnum);
+    cfginfo[UIO_INFOIDX_PWM] |= (1u << unitnum);
   }
 
   else if (UIO_PINTYPE_SPI == pintype)
   {
-    if (active)
+    if (pincfg & UIO_PINFLAG_SPI_CS)  // additional CS pin, selected by the SPI profiles
+    {
+      pcf.hwpinflags = PINCFG_OUTPUT | PINCFG_GPIO_INIT_1;
+      ppin->Assign(ppin->portnum, ppin->pinnum, false);
+    }
+    else if (active)
     {
       SetupSpi(&pcf);
     }
@@ -434,6 +523,15 @@ uint16_t TUioDevBase::SetDacOutput(uint8_t dac_idx, uint16_t avalue)
   }
 
   dac_value[dac_idx] = avalue;  // update the shadow too
+
+#if UIO_DACWAVE_COUNT
+  if ((dac_idx < UIO_DACWAVE_COUNT) && dacwave[dac_idx].active)
+  {
+    dacwave[dac_idx].update = true;  // the output value is the waveform offset
+    return 0;
+  }
+#endif
+
   pdac->SetTo(avalue);
   return 0;
 }
@@ -449,6 +547,193 @@ uint16_t TUioDevBase::SetDacOutputF32(uint8_t dac_idx, float avalue)
 	return SetDacOutput(dac_idx, u16value);
 }
 
+// DAC Waveform generator
+//   The DMA plays the buf circularly, which contains the same period twice.
+//   The parameter updates are written to the half which is not played and the
+//   other half is updated after the DMA moved to the new one. This way the new
+//   table always starts at the period start (zero crossing), without glitches.
+
+uint16_t TUioDevBase::DacWaveSetType(uint8_t dac_idx, uint8_t atype)
+{
+#if UIO_DACWAVE_COUNT
+  unsigned n;
+
+  if ((dac_idx >= UIO_DACWAVE_COUNT) || !ana_out[dac_idx])
+  {
+    return UIOERR_UNITSEL;
+  }
+
+  TUioDacWave * pw = &dacwave[dac_idx];
+
+  if (pw->active)
+  {
+    DacWaveStop(dac_idx);
+    pw->active = false;
+  }
+
+  pw->type = UIO_DACWAVE_OFF;
+  if (UIO_DACWAVE_OFF == atype)
+  {
+    ana_out[dac_idx]->SetTo(dac_value[dac_idx]);
+    return 0;
+  }
+
+  uint32_t ns = UIO_DACWAVE_SAMPLES;
+  if (UIO_DACWAVE_SINE == atype)
+  {
+    for (n = 0; n < ns; ++n)
+    {
+      pw->shape[n] = int16_t(32767.0f * sinf(6.2831853f * n / ns));
+    }
+  }
+  else if (UIO_DACWAVE_TRIANGLE == atype)
+  {
+    for (n = 0; n < ns; ++n)
+    {
+      int32_t v = (131068 * n) / ns;  // 0 .. 4 * 32767
+      if      (v > 3 * 32767)  v = v - 4 * 32767;
+      else if (v > 32767)      v = 2 * 32767 - v;
+      pw->shape[n] = v;
+    }
+  }
+  else if (UIO_DACWAVE_SQUARE == atype)
+  {
+    for (n = 0; n < ns; ++n)
+    {
+      pw->shape[n] = (n < ns / 2 ? 32767 : -32767);
+    }
+  }
+  else if (UIO_DACWAVE_USER == atype)
+  {
+    ns = pw->user_len;
+    if ((ns < 2) || (ns > UIO_DACWAVE_SAMPLES) || (pw->user_offs + 2 * ns > UIO_MPRAM_SIZE))
+    {
+      return UIOERR_UNIT_PARAMS;
+    }
+
+    for (n = 0; n < ns; ++n)
+    {
+      uint16_t u16;
+      memcpy(&u16, &mpram[pw->user_offs + 2 * n], 2);
+      pw->shape[n] = int16_t(u16 ^ 0x8000);  // 0x8000 = zero
+    }
+  }
+  else
+  {
+    return UDOERR_WRITE_VALUE;
+  }
+
+  if (pw->frequency * ns > UIO_DACWAVE_MAX_RATE)
+  {
+    return UIOERR_UNIT_PARAMS;
+  }
+
+  pw->samples = ns;
+  DacWaveBuild(dac_idx, 0);
+  DacWaveBuild(dac_idx, 1);
+  pw->update = false;
+  pw->copyhalf = 0;
+
+  if (!DacWaveStart(dac_idx, &pw->buf[0], 2 * ns, pw->frequency * ns))
+  {
+    return UIOERR_FUNC_NOT_AVAIL;
+  }
+
+  pw->type = atype;
+  pw->active = true;
+  return 0;
+#else
+  return UIOERR_FUNC_NOT_AVAIL;
+#endif
+}
+
+uint16_t TUioDevBase::DacWaveSetFrequency(uint8_t dac_idx, uint32_t afreq)
+{
+#if UIO_DACWAVE_COUNT
+  if (dac_idx >= UIO_DACWAVE_COUNT)
+  {
+    return UIOERR_UNITSEL;
+  }
+
+  TUioDacWave * pw = &dacwave[dac_idx];
+  uint32_t ns = (pw->active ? pw->samples : 1);
+  if ((afreq < 1) || (afreq * ns > UIO_DACWAVE_MAX_RATE))
+  {
+    return UDOERR_WRITE_VALUE;
+  }
+
+  pw->frequency = afreq;
+  if (pw->active)
+  {
+    DacWaveSetRate(dac_idx, afreq * ns);  // the timer period is preloaded, no table change required
+  }
+  return 0;
+#else
+  return UIOERR_FUNC_NOT_AVAIL;
+#endif
+}
+
+void TUioDevBase::DacWaveBuild(uint8_t dac_idx, uint8_t ahalf)
+{
+#if UIO_DACWAVE_COUNT
+  unsigned n;
+  TUioDacWave * pw = &dacwave[dac_idx];
+  uint16_t * pdst = &pw->buf[ahalf * pw->samples];
+  int32_t  offset = dac_value[dac_idx];
+  int32_t  amp = pw->amplitude;
+
+  for (n = 0; n < pw->samples; ++n)
+  {
+    int32_t v = offset + ((pw->shape[n] * amp) >> 15);
+    if      (v < 0)       v = 0;
+    else if (v > 0xFFFF)  v = 0xFFFF;
+    pdst[n] = v;
+  }
+#endif
+}
+
+void TUioDevBase::RunDacWaves()
+{
+#if UIO_DACWAVE_COUNT
+  unsigned n;
+
+  for (n = 0; n < UIO_DACWAVE_COUNT; ++n)
+  {
+    TUioDacWave * pw = &dacwave[n];
+    if (!pw->active || (!pw->update && !pw->copyhalf))
+    {
+      continue;
+    }
+
+    // The circular DMA keeps running while a half is written, so the position is checked again
+    // after the write, and the step is repeated when the DMA reached the written half meanwhile.
+    uint8_t playhalf = (DacWaveReadPos(n) >= pw->samples ? 1 : 0);
+
+    if (pw->copyhalf)
+    {
+      uint8_t oldhalf = pw->copyhalf - 1;
+      if (playhalf != oldhalf)  // the DMA plays already the new table
+      {
+        memcpy(&pw->buf[oldhalf * pw->samples], &pw->buf[(oldhalf ^ 1) * pw->samples], 2 * pw->samples);
+        if (oldhalf != (DacWaveReadPos(n) >= pw->samples ? 1 : 0))
+        {
+          pw->copyhalf = 0;
+        }
+      }
+    }
+    else
+    {
+      DacWaveBuild(n, playhalf ^ 1);
+      if (playhalf == (DacWaveReadPos(n) >= pw->samples ? 1 : 0))
+      {
+        pw->update = false;
+        pw->copyhalf = 1 + playhalf;
+      }
+    }
+  }
+#endif
+}
+
 void TUioDevBase::SaveSetup()
 {
   TRACE("Saving setup...\r\n");
@@ -462,15 +747,18 @@ void TUioDevBase::SaveSetup()
   pstb->checksum = 0;
   pstb->checksum = uio_content_checksum(pstb, sizeof(*pstb));
 
-  // save to flash
+  // save to flash, g_cfgstb stays valid until the job is done
 #if 1
-  g_nvstorage.CopyTo(nvsaddr_setup, pstb, sizeof(*pstb));
+  if (!g_nvstorage.AddJob(UIO_NVS_JOB_COPY, nvsaddr_setup, pstb, sizeof(*pstb)))
+  {
+    g_nvstorage.CopyTo(nvsaddr_setup, pstb, sizeof(*pstb));  // queue full: blocking
+  }
 #else
   g_nvstorage.Erase(nvsaddr_setup, sizeof(*pstb));
   g_nvstorage.Write(nvsaddr_setup, pstb, sizeof(*pstb));
 #endif
 
-  TRACE("Setup save completed.\r\n");
+  TRACE("Setup save started.\r\n");
 }
 
 #if HAS_SPI_FLASH
@@ -479,10 +767,11 @@ void TUioDevBase::SaveSetup()
 
 #endif
 
-void TUioDevBase::LoadSetup()
+bool TUioDevBase::ReadSetup()
 {
   #if HAS_SPI_FLASH
-    g_nvstorage.Read(nvsaddr_setup, &spifl_stb, sizeof(spifl_stb));
+    // read the header first, so an empty flash or a shorter setup does not cost the full read
+    g_nvstorage.Read(nvsaddr_setup, &spifl_stb, offsetof(TUioCfgStb, usb_vendor_id));
     TUioCfgStb * pstb = &spifl_stb;
   #else
     TUioCfgStb * pstb = (TUioCfgStb *)nvsaddr_setup;
@@ -495,28 +784,64 @@ void TUioDevBase::LoadSetup()
   if (pstb->signature != UIOCFG_V2_SIGNATURE)
   {
     TRACE("  signature error: %08X\r\n", pstb->signature);
-    return;
+    return false;
   }
 
-  if (pstb->length != sizeof(TUioCfgStb))
+  // older firmware versions stored shorter setups
+  if ((pstb->length > sizeof(TUioCfgStb)) || (pstb->length < offsetof(TUioCfgStb, dv_douts_hi)))
   {
     TRACE("  config length difference\r\n");
-    return;
+    return false;
   }
 
-  if (0 != uio_content_checksum(pstb, sizeof(TUioCfgStb)))
+  #if HAS_SPI_FLASH
+    g_nvstorage.Read(nvsaddr_setup + offsetof(TUioCfgStb, usb_vendor_id), &spifl_stb.usb_vendor_id,
+                     pstb->length - offsetof(TUioCfgStb, usb_vendor_id));
+  #endif
+
+  if (0 != uio_content_checksum(pstb, pstb->length))
   {
     TRACE("  config checksum error\r\n");
-    return;
+    return false;
   }
 
-  TRACE("Saved setup ok, activating.\r\n");
+  TRACE("Saved setup ok.\r\n");
 
-  cfg = *pstb; // copy to the active configuration
+  // copy to the active configuration, the missing new fields are zeroed
+  memset(&cfg, 0, sizeof(cfg));
+  memcpy(&cfg, pstb, pstb->length);
 
-  // TODO: load runmode
-  runmode = 1;
-  ConfigurePins(true);
+  return true;
+}
+
+void TUioDevBase::LoadSetup()
+{
+  // only the cfg is loaded here, the USB descriptors need the IDs from it.
+  // The pins are configured by the ActivateSetup(), after the USB init.
+  if (ReadSetup())
+  {
+    // TODO: load runmode
+    runmode = 1;
+  }
+
+  BootStamp(UIO_BOOTST_SETUP);
+}
+
+void TUioDevBase::ActivateSetup()
+{
+  TRACE("Activating the setup, runmode = %u\r\n", runmode);
+
+  ConfigurePins(1 == runmode);
+
+  BootStamp(UIO_BOOTST_ACTIVE);
+}
+
+void TUioDevBase::BootStamp(unsigned aphase)
+{
+  if (aphase < UIO_BOOTST_COUNT)
+  {
+    boot_clocks[aphase] = CLOCKCNT;
+  }
 }
 
 void TUioDevBase::ClearConfig()
@@ -535,6 +860,7 @@ void TUioDevBase::ClearConfig()
 
   // set output defaults
   cfg.dv_douts = 0;
+  cfg.dv_douts_hi = 0;
 
   for (n = 0; n < UIO_DAC_COUNT; ++n)
   {
@@ -585,14 +911,34 @@ void TUioDevBase::ConfigurePins(bool active)
     adc_channel[n] = 0x00;
   }
 
+  for (n = 0; n < UIO_CNT_COUNT; ++n)
+  {
+    cnt_state[n].hwmask = 0;
+    cnt_values[n].count = 0;
+    cnt_values[n].period_ns = 0;
+    cnt_values[n].frequency = 0;
+  }
+
   // outputs
 
-  dout_value = cfg.dv_douts;
+  dout_value = (cfg.dv_douts | (uint64_t(cfg.dv_douts_hi) << 32));
   for (n = 0; n < UIO_DOUT_COUNT; ++n)
   {
     dig_out[n] = nullptr;
   }
 
+#if UIO_DACWAVE_COUNT
+  for (n = 0; n < UIO_DACWAVE_COUNT; ++n)
+  {
+    if (dacwave[n].active)
+    {
+      DacWaveStop(n);
+    }
+    dacwave[n].active = false;
+    dacwave[n].type = UIO_DACWAVE_OFF;
+  }
+#endif
+
   for (n = 0; n < UIO_DAC_COUNT; ++n)
   {
     dac_value[n] = cfg.dv_dac[n];
@@ -600,15 +946,34 @@ void TUioDevBase::ConfigurePins(bool active)
 
   for (n = 0; n < UIO_PWM_COUNT; ++n)
   {
+    if (pwm_os_mode & (1 << n))
+    {
+      PwmPulseStop(n);
+    }
     pwmch[n] = nullptr;
+    pwm_os_count[n] = 0;
     pwm_value[n] = cfg.dv_pwm[n];
   }
+  pwm_os_mode = 0;
+  pwm_os_busy = 0;
 
   for (n = 0; n < UIO_LEDBLP_COUNT; ++n)
   {
     ledblp[n] = nullptr;
     ledblp_value[n] = cfg.dv_ledblp[n];
   }
+  blp_restart_mask = 0xFFFF;  // start all the patterns synchronously
+
+  for (n = 0; n < UIO_SPI_COUNT; ++n)  // the CS pins might change
+  {
+    g_spictrl[n].SelectProfile(UIO_SPI_PROFILE_NONE);
+  }
+
+  for (n = 0; n < UIO_I2C_COUNT; ++n)  // the board sets them again for the bus recovery
+  {
+    g_i2cctrl[n].scl_pin = nullptr;
+    g_i2cctrl[n].sda_pin = nullptr;
+  }
 
   // 2. setup the pins and assignments
 
@@ -623,6 +988,156 @@ void TUioDevBase::ConfigurePins(bool active)
       PinSetup(n, 0, false); // set passive
     }
   }
+
+  // 3. prepare the port access tables
+
+  PrepareDigIo();
+}
+
+void TUioDevBase::PrepareDigIo()
+{
+  unsigned n, g;
+
+  // The DOUT / DIN units are grouped by their GPIO port registers, so an update
+  // requires only one register write (or read) per port instead of one per pin.
+  // The TGpioPin pointers and bit values already contain the inversion.
+
+  dout_unit_cnt = 0;
+  dout_grp_cnt = 0;
+  for (n = 0; n < UIO_DOUT_COUNT; ++n)
+  {
+    TGpioPin * ppin = dig_out[n];
+    if (!ppin)
+    {
+      continue;
+    }
+
+    for (g = 0; g < dout_grp_cnt; ++g)
+    {
+      if ((dout_group[g].setreg == ppin->setbitptr) && (dout_group[g].clrreg == ppin->clrbitptr))
+      {
+        break;
+      }
+    }
+
+    if (g >= dout_grp_cnt)
+    {
+      if (dout_grp_cnt >= UIO_IOGRP_MAX)
+      {
+        continue; // should not happen
+      }
+      dout_group[g].setreg = ppin->setbitptr;
+      dout_group[g].clrreg = ppin->clrbitptr;
+      ++dout_grp_cnt;
+    }
+
+    dout_grp[n] = g;
+    dout_setbits[n] = ppin->setbitvalue;
+    dout_clrbits[n] = ppin->clrbitvalue;
+    dout_units[dout_unit_cnt++] = n;
+  }
+
+  din_unit_cnt = 0;
+  din_grp_cnt = 0;
+  for (n = 0; n < UIO_DIN_COUNT; ++n)
+  {
+    TGpioPin * ppin = dig_in[n];
+    if (!ppin)
+    {
+      continue;
+    }
+
+    for (g = 0; g < din_grp_cnt; ++g)
+    {
+      if (din_getreg[g] == ppin->getbitptr)
+      {
+        break;
+      }
+    }
+
+    if (g >= din_grp_cnt)
+    {
+      if (din_grp_cnt >= UIO_IOGRP_MAX)
+      {
+        continue; // should not happen
+      }
+      din_getreg[g] = ppin->getbitptr;
+      ++din_grp_cnt;
+    }
+
+    din_grp[n] = g;
+    din_shift[n] = ppin->getbitshift;
+    din_units[din_unit_cnt++] = n;
+  }
+}
+
+void TUioDevBase::DigOutUpdate(uint64_t avalue, uint64_t amask)
+{
+  unsigned n;
+
+  for (n = 0; n < dout_grp_cnt; ++n)
+  {
+    dout_group[n].setbits = 0;
+    dout_group[n].clrbits = 0;
+  }
+
+  for (n = 0; n < dout_unit_cnt; ++n)
+  {
+    uint8_t  unit  = dout_units[n];
+    uint64_t umask = (uint64_t(1) << unit);
+    if (amask & umask)
+    {
+      TUioDoutGroup * pgrp = &dout_group[dout_grp[unit]];
+      if (avalue & umask)
+      {
+        pgrp->setbits |= dout_setbits[unit];
+      }
+      else
+      {
+        pgrp->clrbits |= dout_clrbits[unit];
+      }
+    }
+  }
+
+  for (n = 0; n < dout_grp_cnt; ++n)
+  {
+    TUioDoutGroup * pgrp = &dout_group[n];
+    if (pgrp->setreg == pgrp->clrreg)
+    {
+      // combined set/reset register (like the STM32 BSRR): all pins of the port change at once
+      if (pgrp->setbits | pgrp->clrbits)
+      {
+        *pgrp->setreg = (pgrp->setbits | pgrp->clrbits);
+      }
+    }
+    else
+    {
+      if (pgrp->setbits)  *pgrp->setreg = pgrp->setbits;
+      if (pgrp->clrbits)  *pgrp->clrreg = pgrp->clrbits;
+    }
+  }
+
+  dout_value = ((dout_value & ~amask) | (avalue & amask));
+}
+
+uint64_t TUioDevBase::DigInRead()
+{
+  unsigned  n;
+  unsigned  portvalue[UIO_IOGRP_MAX];
+  uint64_t  result = 0;
+
+  for (n = 0; n < din_grp_cnt; ++n)
+  {
+    portvalue[n] = *din_getreg[n];
+  }
+
+  for (n = 0; n < din_unit_cnt; ++n)
+  {
+    uint8_t unit = din_units[n];
+    result |= (uint64_t((portvalue[din_grp[unit]] >> din_shift[unit]) & 1) << unit);
+  }
+
+  return result;
 }
 
 void TUioDevBase::SetPwmDuty(uint8_t apwmnum, uint16_t aduty)
@@ -638,11 +1153,66 @@ void TUioDevBase::SetPwmDuty(uint8_t apwmnum, uint16_t aduty)
     return;
   }
 
+  if (pwm_os_mode & (1 << apwmnum))  // return from the single pulse mode
+  {
+    PwmPulseStop(apwmnum);
+    pwm_os_mode &= ~(1 << apwmnum);
+    pwm_os_busy &= ~(1 << apwmnum);
+  }
+
   uint16_t onclocks = ((pwm->periodclocks * aduty) >> 16);
 
   pwm->SetOnClocks(onclocks);
 }
 
+uint16_t TUioDevBase::PwmPulseTrigger(uint8_t apwmnum)
+{
+  if ((apwmnum >= UIO_PWM_COUNT) || !pwmch[apwmnum])
+  {
+    return UIOERR_UNITSEL;
+  }
+
+  if (pwm_os_busy & (1 << apwmnum))
+  {
+    return UDOERR_BUSY;
+  }
+
+  // the output must be inactive before the pulse, so a delay of at least one tick is required
+  if ((pwm_os_delay[apwmnum] < 1) || (pwm_os_width[apwmnum] < 1))
+  {
+    return UIOERR_UNIT_PARAMS;
+  }
+
+  if (!PwmPulseStart(apwmnum, pwm_os_delay[apwmnum], pwm_os_width[apwmnum]))
+  {
+    return UIOERR_FUNC_NOT_AVAIL;
+  }
+
+  pwm_os_mode |= (1 << apwmnum);
+  pwm_os_busy |= (1 << apwmnum);
+
+  return 0;
+}
+
+void TUioDevBase::RunPwmPulses()
+{
+  unsigned n;
+
+  if (!pwm_os_busy)
+  {
+    return;
+  }
+
+  for (n = 0; n < UIO_PWM_COUNT; ++n)
+  {
+    if ((pwm_os_busy & (1 << n)) && !PwmPulseRunning(n))
+    {
+      pwm_os_busy &= ~(1 << n);
+      ++pwm_os_count[n];
+    }
+  }
+}
+
 void TUioDevBase::SetRunMode(uint8_t arunmode)
 {
   // TODO: Save Config
@@ -659,35 +1229,90 @@ void TUioDevBase::SetRunMode(uint8_t arunmode)
   // TODO: Save RunMode
 }
 
-void TUioDevBase::Run() // handle led blink patterns
+void TUioDevBase::LedBlpRestart(uint8_t aidx)
+{
+  // the restart is executed by the tick handler, so the state is not changed concurrently
+  blp_restart_mask |= (1 << aidx);
+}
+
+void TUioDevBase::LedBlpTick()
 {
   unsigned n;
-  unsigned t0 = CLOCKCNT;
 
-  if (t0 - last_blp_time >= blp_bit_clocks)
+  uint32_t rmask = blp_restart_mask;
+  if (rmask)
+  {
+    // an interrupted LedBlpRestart() might write back some bits again, that causes only a repeated restart
+    blp_restart_mask &= ~rmask;
+  }
+
+  for (n = 0; n < UIO_LEDBLP_COUNT; ++n)
   {
-    blp_idx = ((blp_idx + 1) & 0x1F);
-    blp_mask = (1 << blp_idx);
+    TUioBlpState * pst = &blp_state[n];
+    uint32_t skip_ticks = 0;
+
+    if (rmask & (1 << n))
+    {
+      // the phase offset selects the starting bit and the position within that bit
+      pst->bit_ticks = (uint64_t(blp_period_us[n]) * UIO_BLP_TICK_HZ) / 1000000;
+      if (pst->bit_ticks < 1)  pst->bit_ticks = 1;
+      uint32_t phase_ticks = (uint64_t(blp_phase_us[n]) * UIO_BLP_TICK_HZ) / 1000000;
+      phase_ticks %= (pst->bit_ticks * 32);
+      pst->bitidx = ((phase_ticks / pst->bit_ticks) - 1) & 0x1F;  // stepped to the phase bit below
+      pst->tickcnt = 1;
+      skip_ticks = (phase_ticks % pst->bit_ticks);
+    }
+
+    if (--pst->tickcnt)
+    {
+      continue;
+    }
+
+    pst->tickcnt = pst->bit_ticks - skip_ticks;
+    pst->bitidx = ((pst->bitidx + 1) & 0x1F);
 
-    for (n = 0; n < UIO_LEDBLP_COUNT; ++n)
+    TGpioPin * ppin = ledblp[n];
+    if (ppin)
     {
-      TGpioPin * ppin = ledblp[n];
-      if (ppin)
+      if (ledblp_value[n] & (1 << pst->bitidx))
       {
-        if (ledblp_value[n] & blp_mask)
-        {
-          ppin->Set1();
-        }
-        else
-        {
-          ppin->Set0();
-        }
+        ppin->Set1();
+      }
+      else
+      {
+        ppin->Set0();
       }
     }
+  }
+}
+
+void TUioDevBase::Run()
+{
+  unsigned n;
+  unsigned t0 = CLOCKCNT;
 
-    last_blp_time = t0;
+  // main loop cycle time statistics
+  unsigned looptime = t0 - loop_last_time;
+  loop_last_time = t0;
+  if (looptime > loop_max_clocks)  loop_max_clocks = looptime;
+  loop_avg_clocks = loop_avg_clocks - (loop_avg_clocks >> 4) + (looptime >> 4);
+
+  if (!blp_timer_active)  // fallback: blink pattern ticks from the main loop
+  {
+    while (t0 - last_blp_time >= blp_tick_clocks)
+    {
+      LedBlpTick();
+      last_blp_time += blp_tick_clocks;
+    }
   }
 
+  g_nvstorage.Run();  // the NV writes run in the background
+  g_nvdata.Run();     // NV data store compaction
+
+  RunCounters();
+  RunPwmPulses();
+  RunDacWaves();
+
   for (n = 0; n < UIO_SPI_COUNT; ++n)
   {
   	g_spictrl[n].Run();
@@ -710,6 +1335,59 @@ void TUioDevBase::Run() // handle led blink patterns
   RunBoard();
 }
 
+void TUioDevBase::RunCounters()
+{
+  unsigned t0 = CLOCKCNT;
+  unsigned gate_clocks = cnt_gate_us * (SystemCoreClock / 1000000);
+
+  for (unsigned n = 0; n < UIO_CNT_COUNT; ++n)
+  {
+    TUioCntState * pst = &cnt_state[n];
+    if (!pst->hwmask)
+    {
+      continue;
+    }
+
+    // extend the (usually 16-bit) hardware counter to 32 bits,
+    // this must be called at least once per hardware counter overflow
+    TUioCntValues * pv = &cnt_values[n];
+    uint32_t raw = CounterHwValue(n);
+    pv->count += ((raw - pst->last_raw) & pst->hwmask);
+    pst->last_raw = raw;
+
+    unsigned elapsed = t0 - pst->gate_start;
+    if (elapsed >= gate_clocks)
+    {
+      uint32_t gcount = pv->count - pst->gate_count;
+      pv->frequency = float(gcount) * float(SystemCoreClock) / float(elapsed);
+      if (gcount)
+      {
+        pv->period_ns = (uint64_t(elapsed) * 1000000000) / (uint64_t(gcount) * SystemCoreClock);
+      }
+      else
+      {
+        pv->period_ns = 0;
+      }
+
+      pst->gate_count = pv->count;
+      pst->gate_start = t0;
+    }
+  }
+}
+
+void TUioDevBase::SetCounterValue(uint8_t acntidx, uint32_t avalue)
+{
+  if (acntidx >= UIO_CNT_COUNT)
+  {
+    return;
+  }
+
+  // restarts the frequency measurement too
+  cnt_values[acntidx].count = avalue;
+  cnt_state[acntidx].gate_count = avalue;
+  cnt_state[acntidx].gate_start = CLOCKCNT;
+}
+
 uint32_t uio_content_checksum(void * adataptr, uint32_t adatalen)
 {
   int32_t remaining = adatalen;
@@ -737,3 +1415,24 @@ uint32_t uio_content_checksum(void * adataptr, uint32_t adatalen)
 
   return(0 - csum);
 }
+
+uint32_t uio_crc32(uint32_t acrc, const void * adataptr, uint32_t adatalen)
+{
+  // nibble table, small and still fast enough for the 4k sectors
+  static const uint32_t crc_nibble_table[16] =
+  {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+  };
+
+  const uint8_t * dp = (const uint8_t *)adataptr;
+  uint32_t crc = ~acrc;
+  while (adatalen)
+  {
+    crc ^= *dp++;
+    crc = (crc >> 4) ^ crc_nibble_table[crc & 0x0F];
+    crc = (crc >> 4) ^ crc_nibble_table[crc & 0x0F];
+    --adatalen;
+  }
+  return ~crc;
+}
@@ -58,9 +58,13 @@
 #define UIO_DOUT_COUNT     64
 #define UIO_DIN_COUNT      64
 #define UIO_LEDBLP_COUNT   16
+#define UIO_CNT_COUNT       8
 
 #define UIO_ADC_ERROR_VALUE     0x0000
 
+// GPIO register groups for the DIN/DOUT access, normal and inverted pins of a port can use different registers
+#define UIO_IOGRP_MAX      (2 * ((UIO_PIN_COUNT + UIO_PINS_PER_PORT - 1) / UIO_PINS_PER_PORT))
+
 #define UIO_PINTYPE_PASSIVE          0 // default configuration
 #define UIO_PINTYPE_DIG_IN           1 // pullup by default
 #define UIO_PINTYPE_DIG_OUT          2
@@ -73,6 +77,7 @@
 #define UIO_PINTYPE_UART             9
 #define UIO_PINTYPE_CLKOUT          10
 #define UIO_PINTYPE_CAN             11
+#define UIO_PINTYPE_COUNTER         12 // pulse counter / frequency input
 #define UIO_PINTYPE_CUSTOM_MASK   0x80
 
 #define UIO_PINFLAG_DIN_PULLUP       (0x0000 << 16)
@@ -86,6 +91,10 @@
 #define UIO_PINFLAG_DOUT_HIZ_FLOAT   (0x0040 << 16)
 #define UIO_PINFLAG_PWM_INVERT       (0x0001 << 16)
 #define UIO_PINFLAG_LEDBLP_INVERT    (0x0001 << 16)
+#define UIO_PINFLAG_CNT_PULLDN       (0x0001 << 16)
+#define UIO_PINFLAG_CNT_FLOAT        (0x0002 << 16)
+#define UIO_PINFLAG_CNT_FALLING      (0x0004 << 16)  // count the falling edges
+#define UIO_PINFLAG_SPI_CS           (0x0001 << 16)  // additional SPI CS pin (GPIO output) for the SPI profiles
 
 #define UIO_I2C_CMD_WRITE            (1 << 0)
 
@@ -111,8 +120,34 @@
 #define UIO_INFOIDX_DOUT_32    8
 #define UIO_INFOIDX_HIZ_0      9
 #define UIO_INFOIDX_HIZ_32    10
+#define UIO_INFOIDX_CNT       11
+
+#define UIO_BLP_TICK_HZ     2000  // led blink pattern tick frequency
+#define UIO_BLP_DEF_PERIOD  62500  // default led blink pattern bit period in us (1/16 s)
 
-#define UIO_INFO_COUNT        11
+#ifndef UIO_DACWAVE_COUNT
+  #define UIO_DACWAVE_COUNT    0  // number of DAC units (from 0) with waveform generator
+#endif
+#define UIO_DACWAVE_SAMPLES  128  // samples per period for the built-in waveforms
+#define UIO_DACWAVE_MAX_RATE  1000000  // max. samples / s
+
+#define UIO_DACWAVE_OFF        0
+#define UIO_DACWAVE_SINE       1
+#define UIO_DACWAVE_TRIANGLE   2
+#define UIO_DACWAVE_SQUARE     3
+#define UIO_DACWAVE_USER    0x10  // u16 samples from the MPRAM
+
+#define UIO_INFO_COUNT        12
+
+// boot phase time stamps (CLOCKCNT), reported in us at 0x0130
+#define UIO_BOOTST_INIT       0  // TUioDevBase::Init() started
+#define UIO_BOOTST_BOARD      1  // board and peripheral objects initialized
+#define UIO_BOOTST_NVDATA     2  // NV data store scanned
+#define UIO_BOOTST_SETUP      3  // stored setup loaded (not activated yet)
+#define UIO_BOOTST_USB        4  // USB device initialized, enumeration can start
+#define UIO_BOOTST_ACTIVE     5  // pins configured
+#define UIO_BOOTST_FIRST_RQ   6  // first UDO request received
+#define UIO_BOOTST_COUNT      7
 
 #define UIO_INFOCBIT_CLKOUT (1  << 0)
 #define UIO_INFOCBIT_UART   (1  << 1)
@@ -149,6 +184,10 @@ typedef struct
   uint32_t          dv_ledblp[UIO_LEDBLP_COUNT];
 
   uint32_t          pwm_freq[UIO_PWM_COUNT];
+
+  // new fields are appended here, shorter (older) stored setups are accepted too
+
+  uint32_t          dv_douts_hi;  // default values of the DOUT units 32-63
 //
 } TUioCfgStb;
 
@@ -163,18 +202,76 @@ typedef struct
 //
 } TPinCfg;
 
+typedef struct
+{
+  uint32_t          count;        // 32-bit extended pulse count
+  uint32_t          period_ns;    // average pulse period in the last gate window
+  float             frequency;    // pulse frequency in Hz, measured in the last gate window
+//
+} TUioCntValues;  // 12 bytes
+
+typedef struct
+{
+  uint32_t          hwmask;       // width mask of the hardware counter, 0 = not configured
+  uint32_t          last_raw;     // last hardware counter value
+  uint32_t          gate_count;   // count at the gate window start
+  uint32_t          gate_start;   // CLOCKCNT at the gate window start
+//
+} TUioCntState;
+
+typedef struct
+{
+  volatile unsigned *  setreg;
+  volatile unsigned *  clrreg;
+  unsigned             setbits;    // collected set bits for the actual update
+  unsigned             clrbits;    // collected clear bits for the actual update
+//
+} TUioDoutGroup;
+
+typedef struct
+{
+  uint32_t             bit_ticks;  // blink pattern bit period in ticks
+  uint32_t             tickcnt;    // remaining ticks of the actual bit
+  uint8_t              bitidx;     // actual pattern bit
+//
+} TUioBlpState;
+
+typedef struct
+{
+  uint8_t              type;        // UIO_DACWAVE_*
+  bool                 active;      // DMA is running
+  bool                 update;      // the parameters were changed
+  uint8_t              copyhalf;    // 1 + the half which must be overwritten when the DMA left it, 0 = none
+  uint16_t             amplitude;   // peak amplitude, the DAC output value is the offset
+  uint16_t             samples;     // samples per period
+  uint32_t             frequency;   // Hz
+  uint32_t             user_offs;   // user table MPRAM offset
+  uint32_t             user_len;    // user table sample count
+  int16_t              shape[UIO_DACWAVE_SAMPLES];    // normalized waveform
+  uint16_t             buf[2 * UIO_DACWAVE_SAMPLES];  // two copies of the period for the circular DMA
+//
+} TUioDacWave;
+
 class TUioDevBase : public TClass
 {
 public: // internal state
-  uint8_t           blp_idx = 0;
-  uint32_t          blp_mask = 1;
+  bool              blp_timer_active = false;  // false: the ticks are generated from Run()
   unsigned          last_blp_time = 0;
-  unsigned          blp_bit_clocks = 0;
+  unsigned          blp_tick_clocks = 0;
+  volatile uint32_t blp_restart_mask = 0;      // the tick handler restarts these patterns
+  TUioBlpState      blp_state[UIO_LEDBLP_COUNT];
+
+  unsigned          loop_last_time = 0;
+  unsigned          loop_max_clocks = 0;
+  unsigned          loop_avg_clocks = 0;
+
+  uint32_t          boot_clocks[UIO_BOOTST_COUNT] = {0};
 
 public: // NVS info
   uint32_t          nvsaddr_setup = 0;
   uint32_t          nvsaddr_nvdata = 0;
   uint32_t          nvs_sector_size = 0;
+  uint32_t          nvs_nvdata_size = 0;  // 0 = two sectors
 
 public:
   uint8_t           runmode = 0;  // 0 = CONFIG mode, 1 = RUN mode
@@ -192,13 +289,46 @@ public:
   TGpioPin *        dig_in[UIO_DIN_COUNT] = {0};
   uint8_t           adc_channel[UIO_ADC_COUNT] = {0};
 
+  // counters
+  uint32_t          cnt_gate_us = 100000;  // frequency measurement gate time
+  TUioCntValues     cnt_values[UIO_CNT_COUNT];
+  TUioCntState      cnt_state[UIO_CNT_COUNT];
+
   // outputs
-  uint32_t          dout_value = 0;
+  uint64_t          dout_value = 0;
   uint16_t          dac_value[UIO_DAC_COUNT] = {0};
+#if UIO_DACWAVE_COUNT
+  TUioDacWave       dacwave[UIO_DACWAVE_COUNT];
+#endif
   uint16_t          pwm_value[UIO_PWM_COUNT] = {0};
+
+  // PWM single pulse mode, in timer ticks
+  uint32_t          pwm_os_delay[UIO_PWM_COUNT] = {0};
+  uint32_t          pwm_os_width[UIO_PWM_COUNT] = {0};
+  uint32_t          pwm_os_count[UIO_PWM_COUNT] = {0};  // completed pulses
+  uint8_t           pwm_os_mode = 0;  // bit mask: channel switched to single pulse mode
+  uint8_t           pwm_os_busy = 0;  // bit mask: pulse is running
   uint32_t          ledblp_value[UIO_LEDBLP_COUNT] = {0};
+  uint32_t          blp_period_us[UIO_LEDBLP_COUNT];  // bit period
+  uint32_t          blp_phase_us[UIO_LEDBLP_COUNT] = {0};
 
   TGpioPin *        dig_out[UIO_DOUT_COUNT] = {0};
+
+  // precomputed port access tables for the DIN / DOUT, prepared in ConfigurePins()
+  uint8_t           dout_unit_cnt = 0;
+  uint8_t           dout_grp_cnt = 0;
+  uint8_t           dout_units[UIO_DOUT_COUNT];   // list of the configured units
+  uint8_t           dout_grp[UIO_DOUT_COUNT];     // unit -> group index
+  unsigned          dout_setbits[UIO_DOUT_COUNT]; // unit -> bit value written to the group setreg
+  unsigned          dout_clrbits[UIO_DOUT_COUNT]; // unit -> bit value written to the group clrreg
+  TUioDoutGroup     dout_group[UIO_IOGRP_MAX];
+
+  uint8_t           din_unit_cnt = 0;
+  uint8_t           din_grp_cnt = 0;
+  uint8_t           din_units[UIO_DIN_COUNT];
+  uint8_t           din_grp[UIO_DIN_COUNT];
+  uint8_t           din_shift[UIO_DIN_COUNT];
+  volatile unsigned * din_getreg[UIO_IOGRP_MAX];
   TGpioPin *        ledblp[UIO_LEDBLP_COUNT] = {0};
   THwPwmChannel *   pwmch[UIO_PWM_COUNT] = {0};
   THwDacChannel *   ana_out[UIO_DAC_COUNT] = {0};
@@ -211,20 +341,39 @@ public:
   void              Run();
   void              ClearConfig();
   void              ResetConfig();
+  void              ActivateSetup();  // the single pin configuration pass at startup, after LoadSetup()
+  void              BootStamp(unsigned aphase);
   virtual void      ConfigurePins(bool active);
   void              SetPwmDuty(uint8_t apwmnum, uint16_t aduty);
+  uint16_t          PwmPulseTrigger(uint8_t apwmnum);
+  void              RunPwmPulses();
+
+  void              PrepareDigIo();
+  void              DigOutUpdate(uint64_t avalue, uint64_t amask);
+  uint64_t          DigInRead();
 
   virtual uint16_t  SetDacOutput(uint8_t dac_idx, uint16_t avalue);
   virtual uint16_t  SetDacOutputF32(uint8_t dac_idx, float avalue);
 
+  uint16_t          DacWaveSetType(uint8_t dac_idx, uint8_t atype);
+  uint16_t          DacWaveSetFrequency(uint8_t dac_idx, uint32_t afreq);
+  void              DacWaveBuild(uint8_t dac_idx, uint8_t ahalf);
+  void              RunDacWaves();
+
   virtual uint16_t  GetAdcValue(uint8_t adc_idx, uint16_t * rvalue);
   virtual uint16_t  GetAdcValueF32(uint8_t adc_idx, float * rvalue);
 
+  void              RunCounters();
+  void              SetCounterValue(uint8_t acntidx, uint32_t avalue);
+
+  void              LedBlpTick();  // called from the board timer interrupt at UIO_BLP_TICK_HZ
+  void              LedBlpRestart(uint8_t aidx);
 
 public:  // base class mandatory implementations
   virtual bool      InitDevice();
   virtual void      SaveSetup();
-  virtual void      LoadSetup();
+  virtual void      LoadSetup();  // loads only the cfg, ActivateSetup() applies it
+  bool              ReadSetup();  // false: no valid stored setup
   virtual void      SetRunMode(uint8_t arunmode);
 
 public: // board specific virtuals
@@ -241,6 +390,18 @@ public: // board specific virtuals
   virtual void      SetupCan(TPinCfg * pcf) { }
   virtual void      SetupCustom(TPinCfg * pcf, uint8_t pintype) { }
   virtual void      SetupClockOut(TPinCfg * pcf) { }
+  virtual uint32_t  SetupCounter(TPinCfg * pcf) { return 0; }  // returns the hw counter width mask, 0 = error
+  virtual uint32_t  CounterHwValue(uint8_t acntidx) { return 0; }
+  virtual bool      StartBlpTimer() { return false; }  // periodic interrupt calling LedBlpTick()
+  virtual bool      SpiReconfigure(THwSpi * aspi) { return false; }  // apply the speed / mode without full re-init
+  virtual bool      PwmPulseStart(uint8_t apwmnum, uint32_t adelay, uint32_t awidth) { return false; }
+  virtual bool      PwmPulseRunning(uint8_t apwmnum) { return false; }
+  virtual void      PwmPulseStop(uint8_t apwmnum) { }  // back to the periodic mode
+  // timer triggered circular DMA from abuf (asamples) to the DAC
+  virtual bool      DacWaveStart(uint8_t adacnum, uint16_t * abuf, uint32_t asamples, uint32_t arate) { return false; }
+  virtual void      DacWaveStop(uint8_t adacnum) { }
+  virtual void      DacWaveSetRate(uint8_t adacnum, uint32_t arate) { }  // must take effect at the next sample
+  virtual uint32_t  DacWaveReadPos(uint8_t adacnum) { return 0; }  // index of the actual DMA sample
 
   virtual bool      LoadBuiltinConfig(uint8_t anum) { return false; }
 
@@ -263,5 +424,6 @@ extern THwDmaChannel    g_dma_uart_tx[UIO_UART_COUNT];
 extern THwDmaChannel    g_dma_uart_rx[UIO_UART_COUNT];
 
 uint32_t uio_content_checksum(void * adataptr, uint32_t adatalen);
+uint32_t uio_crc32(uint32_t acrc, const void * adataptr, uint32_t adatalen);  // IEEE 802.3, start with 0
 
 #endif
@@ -26,8 +26,10 @@
 */
 
 #include "uio_device.h"
+#include "string.h"
 #include "uio_core_version.h"
 #include "uio_nvdata.h"
+#include "uio_nvstorage.h"
 #include "udoslave.h"
 #include "board_pins.h"
 
@@ -51,6 +53,29 @@ bool TUioDevice::prfn_0100_DevId(TUdoRequest * rq, TParamRangeDef * prdef)
     case 0x0110:  return udo_ro_uint(rq, UIO_PIN_COUNT, 1);
     case 0x0111:  return udo_ro_uint(rq, UIO_PINS_PER_PORT, 1);
     case 0x0112:  return udo_ro_uint(rq, UIO_MPRAM_SIZE, 4);
+
+    case 0x0120:  // main loop cycle time statistics in CPU clocks, write resets the maximum
+    {
+      if (rq->iswrite)
+      {
+        loop_max_clocks = 0;
+        return udo_response_ok(rq);
+      }
+      return udo_ro_uint(rq, loop_max_clocks, 4);
+    }
+    case 0x0121:  return udo_ro_uint(rq, loop_avg_clocks, 4);
+    case 0x0122:  return udo_ro_uint(rq, SystemCoreClock, 4);
+
+    case 0x0130:  // boot phase time stamps in us (UIO_BOOTST_...), 0 = not reached yet
+    {
+      uint32_t  boot_us[UIO_BOOTST_COUNT];
+      unsigned  clocks_per_us = SystemCoreClock / 1000000;
+      for (unsigned n = 0; n < UIO_BOOTST_COUNT; ++n)
+      {
+        boot_us[n] = boot_clocks[n] / clocks_per_us;
+      }
+      return udo_ro_data(rq, &boot_us[0], sizeof(boot_us));
+    }
   }
 
   return udo_response_error(rq, UDOERR_INDEX);
@@ -136,6 +161,11 @@ bool TUioDevice::prfn_PinConfig(TUdoRequest * rq, TParamRangeDef * prdef)
 
 bool TUioDevice::prfn_DefValue_DigOut(TUdoRequest * rq, TParamRangeDef * prdef)
 {
+  if (rq->index & 1) // DOUT 32-63
+  {
+    return udo_rw_data(rq, &cfg.dv_douts_hi, sizeof(cfg.dv_douts_hi));
+  }
+
   return udo_rw_data(rq, &cfg.dv_douts, sizeof(cfg.dv_douts));
 }
 
@@ -215,6 +245,41 @@ bool TUioDevice::prfn_NvData(TUdoRequest * rq, TParamRangeDef * prdef)
     return udo_rw_data(rq, &g_nvdata.lock, sizeof(g_nvdata.lock));
   }
 
+  if (0x81 == idx) // NV write job status: u32 jobs added, u32 jobs done
+  {
+    uint32_t st[2] = {g_nvstorage.jobs_added, g_nvstorage.jobs_done};
+    return udo_ro_data(rq, &st[0], sizeof(st));
+  }
+
+  if (0x82 == idx) // NV data store wear: u32 erase counter per sector
+  {
+    return udo_ro_data(rq, &g_nvdata.sec_erase_cnt[0], g_nvdata.sector_cnt * 4);
+  }
+
+  if (0x83 == idx) // NV data store status
+  {
+    TUioNvKvStatus st;
+    g_nvdata.GetStatus(&st);
+    return udo_ro_data(rq, &st, sizeof(st));
+  }
+
+  if (0x84 == idx) // NV data variable length value, the offset is the key id
+  {
+    uint16_t id = rq->offset;
+    if (rq->iswrite)
+    {
+      return udo_response_error(rq, g_nvdata.SetValue(id, rq->dataptr, rq->rqlen));
+    }
+
+    TUioNvKvKey * pkey = g_nvdata.FindKey(id);
+    if (!pkey)
+    {
+      return udo_response_error(rq, UDOERR_INDEX);
+    }
+    rq->offset = 0;
+    return udo_ro_data(rq, &pkey->data[0], pkey->len);
+  }
+
   if (idx >= UIO_NVDATA_COUNT)
   {
     return udo_response_error(rq, UDOERR_INDEX);
@@ -236,62 +301,54 @@ bool TUioDevice::prfn_DigOutSetClr(TUdoRequest * rq, TParamRangeDef * prdef)
     return udo_response_error(rq, UDOERR_WRITE_ONLY);
   }
 
-  unsigned idx = (rq->index & 0x01);
+  unsigned idx = (rq->index & 0x03);  // 16 units per object
   uint32_t rv32 = udorq_uintvalue(rq);
 
   //TRACE("DOUT(%04X) <- %08X\r\n", rq->index, rv32);
 
-  for (unsigned n = 0; n < 16; ++n)
-  {
-    unsigned pnum = n + (16 * idx);
-    if (pnum < UIO_DOUT_COUNT)
-    {
-      TGpioPin *  ppin = dig_out[pnum];
-      if (ppin)
-      {
-        uint32_t smask = (1 << n);
-        uint32_t cmask = (1 << (n + 16));
-        if (rv32 & smask)
-        {
-          ppin->Set1();
-          dout_value |= (1 << pnum);
-        }
-        else if (rv32 & cmask)
-        {
-          ppin->Set0();
-          dout_value &= ~(1 << pnum);
-        }
-      }
-    }
-  }
+  // lower 16 bits: set, upper 16 bits: clear, the set has priority
+  uint64_t setmask = (rv32 & 0xFFFF);
+  uint64_t clrmask = ((rv32 >> 16) & ~setmask);
+
+  DigOutUpdate(setmask << (16 * idx), (setmask | clrmask) << (16 * idx));
 
   return udo_response_ok(rq);
 }
 
 bool TUioDevice::prfn_DigOutDirect(TUdoRequest * rq, TParamRangeDef * prdef)
 {
-  if (!rq->iswrite)
+  // 0x1010: DOUT 0-31, 0x1011: DOUT 32-63, 0x1012: DOUT 0-63 as one 64-bit value
+  unsigned idx = (rq->index & 0x03);
+  if (idx > 2)
   {
-    return udo_ro_uint(rq, dout_value, 4);
+    return udo_response_error(rq, UDOERR_INDEX);
   }
 
-  dout_value = udorq_uintvalue(rq);
+  if (!rq->iswrite)
+  {
+    if (2 == idx)
+    {
+      uint64_t v64 = dout_value;
+      return udo_ro_data(rq, &v64, sizeof(v64));
+    }
+
+    return udo_ro_uint(rq, uint32_t(dout_value >> (32 * idx)), 4);
+  }
 
-  for (unsigned n = 0; n < UIO_DOUT_COUNT; ++n)
+  if (2 == idx)
   {
-    TGpioPin *  ppin = dig_out[n];
-    if (ppin)
+    if (rq->rqlen < 8)
     {
-      uint32_t smask = (1 << n);
-      if (dout_value & smask)
-      {
-        ppin->Set1();
-      }
-      else
-      {
-        ppin->Set0();
-      }
+      return udo_response_error(rq, UDOERR_WRITE_VALUE);
     }
+
+    uint64_t v64;
+    memcpy(&v64, rq->dataptr, sizeof(v64));
+    DigOutUpdate(v64, 0xFFFFFFFFFFFFFFFFull);
+  }
+  else
+  {
+    DigOutUpdate(uint64_t(udorq_uintvalue(rq)) << (32 * idx), uint64_t(0xFFFFFFFF) << (32 * idx));
   }
 
   return udo_response_ok(rq);
@@ -299,22 +356,98 @@ bool TUioDevice::prfn_DigOutDirect(TUdoRequest * rq, TParamRangeDef * prdef)
 
 bool TUioDevice::prfn_DigInValues(TUdoRequest * rq, TParamRangeDef * prdef)
 {
+  // 0x1100: DIN 0-31, 0x1101: DIN 32-63, 0x1102: DIN 0-63 as one 64-bit value
+  // the whole process image is sampled at once
+  unsigned idx = (rq->index & 0x03);
+  if (idx > 2)
+  {
+    return udo_response_error(rq, UDOERR_INDEX);
+  }
+
   if (rq->iswrite)
   {
     return udo_response_error(rq, UDOERR_READ_ONLY);
   }
 
-  uint32_t rv32 = 0;
-  for (unsigned n = 0; n < UIO_DIN_COUNT; ++n)
+  uint64_t v64 = DigInRead();
+  if (2 == idx)
+  {
+    return udo_ro_data(rq, &v64, sizeof(v64));
+  }
+
+  return udo_ro_uint(rq, uint32_t(v64 >> (32 * idx)), 4);
+}
+
+bool TUioDevice::prfn_CounterCtrl(TUdoRequest * rq, TParamRangeDef * prdef)
+{
+  uint8_t idx  = (rq->index & 0x0F);
+  uint8_t func = (rq->index & 0xF0);
+
+  if (0xB0 == func) // gate time for the frequency measurement
+  {
+    if (0 != idx)
+    {
+      return udo_response_error(rq, UDOERR_INDEX);
+    }
+
+    if (rq->iswrite)
+    {
+      uint32_t rv32 = udorq_uintvalue(rq);
+      if ((rv32 < 1000) || (rv32 > 10000000))  // 1 ms - 10 s
+      {
+        return udo_response_error(rq, UDOERR_WRITE_VALUE);
+      }
+      cnt_gate_us = rv32;
+      return udo_response_ok(rq);
+    }
+
+    return udo_ro_uint(rq, cnt_gate_us, 4);
+  }
+  else if (0xC0 == func) // all counter values in one block
+  {
+    if (rq->iswrite)
+    {
+      return udo_response_error(rq, UDOERR_READ_ONLY);
+    }
+
+    return udo_ro_data(rq, &cnt_values[0], sizeof(cnt_values));
+  }
+
+  if (idx >= UIO_CNT_COUNT)
+  {
+    return udo_response_error(rq, UIOERR_UNITSEL);
+  }
+
+  if (0x80 == func) // pulse count, writable for reset
+  {
+    if (rq->iswrite)
+    {
+      SetCounterValue(idx, udorq_uintvalue(rq));
+      return udo_response_ok(rq);
+    }
+
+    return udo_ro_uint(rq, cnt_values[idx].count, 4);
+  }
+  else if (0x90 == func) // period in ns
+  {
+    if (rq->iswrite)
+    {
+      return udo_response_error(rq, UDOERR_READ_ONLY);
+    }
+
+    return udo_ro_uint(rq, cnt_values[idx].period_ns, 4);
+  }
+  else if (0xA0 == func) // frequency in Hz (F32)
   {
-    TGpioPin *  ppin = dig_in[n];
-    uint32_t    pmask = (1 << n);
-    if (ppin && ppin->Value())
+    if (rq->iswrite)
     {
-      rv32 |= pmask;
+      return udo_response_error(rq, UDOERR_READ_ONLY);
     }
+
+    return udo_ro_f32(rq, cnt_values[idx].frequency);
   }
-  return udo_ro_uint(rq, rv32, 4);
+
+  return udo_response_error(rq, UDOERR_INDEX);
 }
 
 bool TUioDevice::prfn_AnaInValues(TUdoRequest * rq, TParamRangeDef * prdef)
@@ -396,18 +529,59 @@ bool TUioDevice::prfn_AnaOutCtrl(TUdoRequest * rq, TParamRangeDef * prdef)
     }
   }
 
+#if UIO_DACWAVE_COUNT
+  else if (idx >= UIO_DACWAVE_COUNT)
+  {
+    // no waveform generator for this unit
+  }
   else if (0x20 == func) // Waveform type
   {
-    // not handled yet
+    if (!rq->iswrite)
+    {
+      return udo_ro_uint(rq, dacwave[idx].type, 1);
+    }
+
+    r = DacWaveSetType(idx, udorq_uintvalue(rq));
+    if (r)
+    {
+      return udo_response_error(rq, r);
+    }
+    return udo_response_ok(rq);
   }
-  else if (0x40 == func) // Amplitude
+  else if (0x40 == func) // Amplitude (peak, the output value is the offset)
   {
-    // not handled yet
+    if (!rq->iswrite)
+    {
+      return udo_ro_uint(rq, dacwave[idx].amplitude, 2);
+    }
+
+    dacwave[idx].amplitude = udorq_uintvalue(rq);
+    dacwave[idx].update = true;
+    return udo_response_ok(rq);
   }
-  else if (0x60 == func) // Frequency
+  else if (0x60 == func) // Frequency in Hz
   {
-    // not handled yet
+    if (!rq->iswrite)
+    {
+      return udo_ro_uint(rq, dacwave[idx].frequency, 4);
+    }
+
+    r = DacWaveSetFrequency(idx, udorq_uintvalue(rq));
+    if (r)
+    {
+      return udo_response_error(rq, r);
+    }
+    return udo_response_ok(rq);
+  }
+  else if (0x80 == func) // user waveform MPRAM offset, applied at the waveform type setting
+  {
+    return udo_rw_data(rq, &dacwave[idx].user_offs, sizeof(dacwave[0].user_offs));
+  }
+  else if (0x90 == func) // user waveform sample count
+  {
+    return udo_rw_data(rq, &dacwave[idx].user_len, sizeof(dacwave[0].user_len));
   }
+#endif
 
   return udo_response_error(rq, UDOERR_INDEX);
 }
@@ -436,9 +610,40 @@ bool TUioDevice::prfn_PwmControl(TUdoRequest * rq, TParamRangeDef * prdef)
 
     return udo_response_ok(rq);
   }
-  else if (0x20 == func) // single pulse mode
+  else if (0x20 == func) // single pulse mode: write = trigger, read = pulse running
+  {
+    if (!rq->iswrite)
+    {
+      return udo_ro_uint(rq, (pwm_os_busy >> idx) & 1, 1);
+    }
+
+    uint16_t err = PwmPulseTrigger(idx);
+    if (err)
+    {
+      return udo_response_error(rq, err);
+    }
+    return udo_response_ok(rq);
+  }
+  else if (0x40 == func) // single pulse delay in timer ticks
+  {
+    return udo_rw_data(rq, &pwm_os_delay[idx], sizeof(pwm_os_delay[0]));
+  }
+  else if (0x60 == func) // single pulse width in timer ticks
+  {
+    return udo_rw_data(rq, &pwm_os_width[idx], sizeof(pwm_os_width[0]));
+  }
+  else if (0x80 == func) // completed single pulse count
   {
-    // not handled yet
+    return udo_rw_data(rq, &pwm_os_count[idx], sizeof(pwm_os_count[0]));
+  }
+  else if (0xA0 == func) // timer tick frequency
+  {
+    THwPwmChannel * pwm = pwmch[idx];
+    if (!pwm)
+    {
+      return udo_response_error(rq, UIOERR_UNITSEL);
+    }
+    return udo_ro_uint(rq, pwm->frequency * pwm->periodclocks, 4);
   }
 
   return udo_response_error(rq, UDOERR_INDEX);
@@ -447,12 +652,37 @@ bool TUioDevice::prfn_PwmControl(TUdoRequest * rq, TParamRangeDef * prdef)
 bool TUioDevice::prfn_LedBlpCtrl(TUdoRequest * rq, TParamRangeDef * prdef)
 {
   uint8_t idx  = (rq->index & 0x1F);
+  uint8_t func = (rq->index & 0xE0);
   if (idx >= UIO_LEDBLP_COUNT)
   {
     return udo_response_error(rq, UIOERR_UNITSEL);
   }
 
-  return udo_rw_data(rq, &ledblp_value[idx], sizeof(ledblp_value[0]));
+  if (0x00 == func)
+  {
+    return udo_rw_data(rq, &ledblp_value[idx], sizeof(ledblp_value[0]));
+  }
+
+  if ((0x20 == func) || (0x40 == func))  // bit period or phase offset in us
+  {
+    uint32_t * pvalue = (0x20 == func ? &blp_period_us[idx] : &blp_phase_us[idx]);
+    if (!rq->iswrite)
+    {
+      return udo_ro_uint(rq, *pvalue, 4);
+    }
+
+    uint32_t rv32 = udorq_uintvalue(rq);
+    if ((0x20 == func) && ((rv32 < 1000000 / UIO_BLP_TICK_HZ) || (rv32 > 10000000)))  // one tick - 10 s
+    {
+      return udo_response_error(rq, UDOERR_WRITE_VALUE);
+    }
+
+    *pvalue = rv32;
+    LedBlpRestart(idx);
+    return udo_response_ok(rq);
+  }
+
+  return udo_response_error(rq, UDOERR_INDEX);
 }
 
 bool TUioDevice::prfn_Mpram(TUdoRequest * rq, TParamRangeDef * prdef)
@@ -53,6 +53,7 @@ public:
   bool       prfn_DigOutSetClr(TUdoRequest * rq, TParamRangeDef * prdef);
   bool       prfn_DigOutDirect(TUdoRequest * rq, TParamRangeDef * prdef);
   bool       prfn_DigInValues(TUdoRequest * rq, TParamRangeDef * prdef);
+  bool       prfn_CounterCtrl(TUdoRequest * rq, TParamRangeDef * prdef);
   bool       prfn_AnaInValues(TUdoRequest * rq, TParamRangeDef * prdef);
   bool       prfn_AnaOutCtrl(TUdoRequest * rq, TParamRangeDef * prdef);
   bool       prfn_PwmControl(TUdoRequest * rq, TParamRangeDef * prdef);
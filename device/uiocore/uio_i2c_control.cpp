@@ -27,6 +27,8 @@
 
 #include "uio_i2c_control.h"
 #include "uio_dev_base.h"
+#include "clockcnt.h"
+#include "string.h"
 
 THwI2c       g_i2c[UIO_I2C_COUNT];
 TUioI2cCtrl  g_i2cctrl[UIO_I2C_COUNT];
@@ -38,19 +40,137 @@ void TUioI2cCtrl::Init(TUioDevBase * adevbase, THwI2c * ai2c)
   i2ctra.completed = true;
 }
 
-uint16_t TUioI2cCtrl::I2cStart()
+void TUioI2cCtrl::PrepareBus()
 {
-  if (0xFFFF == i2c_result)
+  // the peripheral is re-initialized only when the speed changes or after an error,
+  // the RP2040 requires a re-init after failed transactions
+  if ((i2c->speed != i2c_speed) || reinit_required)
   {
-    return UDOERR_BUSY;
+    i2c->speed = i2c_speed;
+    i2c->Init(i2c->devnum); // re-init the device
+    reinit_required = false;
+    ++reinit_cnt;
+  }
+}
+
+static void i2c_recovery_delay(unsigned aclocks)
+{
+  unsigned t0 = CLOCKCNT;
+  while (CLOCKCNT - t0 < aclocks)
+  {
+    // wait
+  }
+}
+
+void TUioI2cCtrl::BusRecovery()
+{
+  // A slave might hold the SDA low when a transaction was interrupted.
+  // Clocking the SCL up to 9 times releases it, then a STOP condition resets the slaves.
+
+  ++recovery_cnt;
+
+  if (scl_pin && sda_pin)
+  {
+    unsigned halfclk = SystemCoreClock / 200000;  // 100 kHz
+    unsigned n;
+
+    sda_pin->Setup(PINCFG_OUTPUT | PINCFG_OPENDRAIN | PINCFG_PULLUP | PINCFG_GPIO_INIT_1);
+    scl_pin->Setup(PINCFG_OUTPUT | PINCFG_OPENDRAIN | PINCFG_PULLUP | PINCFG_GPIO_INIT_1);
+    i2c_recovery_delay(halfclk);
+
+    for (n = 0; n < 9; ++n)
+    {
+      if (sda_pin->Value())  // released
+      {
+        break;
+      }
+      scl_pin->Set0();
+      i2c_recovery_delay(halfclk);
+      scl_pin->Set1();
+      i2c_recovery_delay(halfclk);
+    }
+
+    // STOP: SDA rising while SCL is high
+    scl_pin->Set0();
+    i2c_recovery_delay(halfclk);
+    sda_pin->Set0();
+    i2c_recovery_delay(halfclk);
+    scl_pin->Set1();
+    i2c_recovery_delay(halfclk);
+    sda_pin->Set1();
+    i2c_recovery_delay(halfclk);
+
+    scl_pin->Setup(scl_pinflags);
+    sda_pin->Setup(sda_pinflags);
+  }
+
+  reinit_required = true;
+  PrepareBus();
+}
+
+bool TUioI2cCtrl::TransactionFinished()
+{
+  i2c->Run();
+  if (i2ctra.completed)
+  {
+    uint32_t us = (CLOCKCNT - tra_start_time) / (SystemCoreClock / 1000000);
+    tra_last_us = us;
+    if (us > tra_max_us)  tra_max_us = us;
+
+    if (i2ctra.error)
+    {
+      reinit_required = true;
+      if (sda_pin && !sda_pin->Value())  // the bus is stuck
+      {
+        BusRecovery();
+      }
+    }
+    return true;
+  }
+
+  if (CLOCKCNT - tra_start_time > tra_timeout_clocks)
+  {
+    // the transaction is dropped, the peripheral is reset by the recovery
+    ++timeout_cnt;
+    i2c->curtra = nullptr;
+    i2c->lasttra = nullptr;
+    BusRecovery();
+    i2ctra.error = UIO_I2C_ERR_TIMEOUT;
+    i2ctra.completed = true;
+    return true;
+  }
+
+  return false;
+}
+
+void TUioI2cCtrl::StartOp(uint8_t aaddr, uint32_t aeaddr, uint8_t aealen, bool awrite, uint8_t * adata, uint16_t alen)
+{
+  uint32_t  extra  = (aeaddr & 0xFFFFFF) | (aealen << 24);
+
+  // timeout: 4x the nominal transfer time + 10 ms for clock stretching
+  uint32_t bits = 9 * (alen + aealen + 1);
+  uint64_t tclocks = (uint64_t(4 * bits) * SystemCoreClock) / i2c_speed + SystemCoreClock / 100;
+  tra_timeout_clocks = (tclocks < 0x7FFFFFFF ? tclocks : 0x7FFFFFFF);  // the clock counter wraps around
+  tra_start_time = CLOCKCNT;
+
+  if (awrite)
+  {
+    i2c->StartWrite(&i2ctra, aaddr, extra, adata, alen);
+  }
+  else
+  {
+    i2c->StartRead(&i2ctra,  aaddr, extra, adata, alen);
   }
+}
 
+uint16_t TUioI2cCtrl::I2cStart()
+{
   if (!i2c)
   {
     return UIOERR_UNITSEL;
   }
 
-  if (!i2ctra.completed)
+  if (Busy())
   {
     return UDOERR_BUSY;
   }
@@ -63,41 +183,213 @@ uint16_t TUioI2cCtrl::I2cStart()
     return UIOERR_UNIT_PARAMS;
   }
 
-  if (i2c->speed != i2c_speed)
+  PrepareBus();
+
+  StartOp((i2c_cmd >> 1) & 0x7F, i2c_eaddr, edata_len, (0 != (i2c_cmd & UIO_I2C_CMD_WRITE)),
+          &devbase->mpram[i2c_data_offs], i2c_trlen);
+
+  i2c_result = 0xFFFF;
+
+  return 0;
+}
+
+uint16_t TUioI2cCtrl::ScriptStart()
+{
+  unsigned n;
+
+  if (!i2c)
   {
-    i2c->speed = i2c_speed;
+    return UIOERR_UNITSEL;
   }
 
-  // RP2040 bug: re-init (? reset) required sometimes
-  i2c->Init(i2c->devnum); // re-init the device
+  if (Busy())
+  {
+    return UDOERR_BUSY;
+  }
 
-  uint8_t   addr   = (i2c_cmd >> 1) & 0x7F;
-  uint32_t  extra  = (i2c_eaddr & 0xFFFFFF) | (edata_len << 24);
+  if ((0 == i2c_speed) || (0 == scr_cnt) || (scr_cnt > UIO_I2C_SCRIPT_MAX) || (scr_offs & 3)
+      || (scr_offs + scr_cnt * sizeof(TUioI2cScriptOp) > UIO_MPRAM_SIZE))
+  {
+    return UIOERR_UNIT_PARAMS;
+  }
 
-  if (i2c_cmd & UIO_I2C_CMD_WRITE)
+  // check all the operations before starting
+  TUioI2cScriptOp * pop = (TUioI2cScriptOp *)&devbase->mpram[scr_offs];
+  for (n = 0; n < scr_cnt; ++n, ++pop)
   {
-    i2c->StartWrite(&i2ctra, addr, extra, &devbase->mpram[i2c_data_offs], i2c_trlen);
+    if ((pop->len > UIO_MPRAM_SIZE - pop->data_offs) || (pop->addr > 0x7F))
+    {
+      scr_idx = n;
+      return UIOERR_UNIT_PARAMS;
+    }
   }
-  else
+
+  PrepareBus();
+
+  scr_idx = 0;
+  scr_state = 0;
+  scr_result = 0xFFFF;
+
+  RunScript();
+
+  return 0;
+}
+
+void TUioI2cCtrl::RunScript()
+{
+  TUioI2cScriptOp * pop = ((TUioI2cScriptOp *)&devbase->mpram[scr_offs]) + scr_idx;
+
+  while (true)
+  {
+    if (0 == scr_state)  // start the next operation
+    {
+      if (scr_idx >= scr_cnt)
+      {
+        scr_result = 0;
+        return;
+      }
+
+      if (pop->len)
+      {
+        StartOp(pop->addr, pop->eaddr, ((pop->flags >> UIO_I2CSCR_EALEN_SHIFT) & 3),
+                (0 != (pop->flags & UIO_I2CSCR_FLAG_WRITE)), &devbase->mpram[pop->data_offs], pop->len);
+      }
+      scr_state = 1;
+    }
+
+    if (1 == scr_state)  // transaction running
+    {
+      if (pop->len)
+      {
+        if (!TransactionFinished())
+        {
+          return;
+        }
+
+        if (i2ctra.error)  // stop at the first error (NAK), the scr_idx shows the failing step
+        {
+          scr_result = i2ctra.error;
+          return;
+        }
+      }
+
+      scr_delay_clocks = pop->delay_us * (SystemCoreClock / 1000000);
+      scr_delay_start = CLOCKCNT;
+      scr_state = 2;
+    }
+
+    if (2 == scr_state)  // delay after the operation
+    {
+      if (CLOCKCNT - scr_delay_start < scr_delay_clocks)
+      {
+        return;
+      }
+
+      ++scr_idx;
+      ++pop;
+      scr_state = 0;
+    }
+  }
+}
+
+uint16_t TUioI2cCtrl::PollStart()
+{
+  if (!i2c)
   {
-    i2c->StartRead(&i2ctra,  addr, extra, &devbase->mpram[i2c_data_offs], i2c_trlen);
+    return UIOERR_UNITSEL;
   }
 
-  i2c_result = 0xFFFF;
+  if ((poll_period_us < 100) || (poll_period_us > 60000000) || (0 == scr_cnt)
+      || (poll_src_offs + poll_len > UIO_MPRAM_SIZE)
+      || (poll_slot_offs & 3) || (poll_slot_offs + 2 * PollSlotSize() > UIO_MPRAM_SIZE))
+  {
+    return UIOERR_UNIT_PARAMS;
+  }
+
+  poll_seq = 0;
+  poll_errcnt = 0;
+  poll_lasterr = 0;
+  poll_latecnt = 0;
+  poll_running = false;
+  poll_period_clocks = poll_period_us * (SystemCoreClock / 1000000);
+  poll_next_time = CLOCKCNT;
+  poll_active = true;
 
   return 0;
 }
 
+void TUioI2cCtrl::RunPoll()
+{
+  if (poll_running)
+  {
+    if (0xFFFF == scr_result)
+    {
+      return;
+    }
+
+    poll_running = false;
+    if (scr_result)
+    {
+      ++poll_errcnt;
+      poll_lasterr = ((scr_idx << 16) | scr_result);
+    }
+    else
+    {
+      // the data goes into the slot which is not the newest, then the sequence number makes it valid
+      uint32_t seq = poll_seq + 1;
+      uint8_t * pslot = &devbase->mpram[poll_slot_offs + (seq & 1) * PollSlotSize()];
+      memcpy(pslot + 4, &devbase->mpram[poll_src_offs], poll_len);
+      *(uint32_t *)pslot = seq;
+      poll_seq = seq;
+    }
+  }
+
+  unsigned t = CLOCKCNT;
+  if (int(t - poll_next_time) < 0)
+  {
+    return;
+  }
+
+  if (Busy())  // a host transaction is running, try later
+  {
+    return;
+  }
+
+  if (t - poll_next_time >= poll_period_clocks)
+  {
+    poll_latecnt += (t - poll_next_time) / poll_period_clocks;
+    poll_next_time = t;
+  }
+  poll_next_time += poll_period_clocks;
+
+  if (0 == ScriptStart())
+  {
+    poll_running = true;
+  }
+  else
+  {
+    ++poll_errcnt;
+  }
+}
+
 void TUioI2cCtrl::Run()
 {
   if (0xFFFF == i2c_result)
   {
-    i2c->Run();
-    if (i2ctra.completed)
+    if (TransactionFinished())
     {
       i2c_result = i2ctra.error;
     }
   }
+  else if (0xFFFF == scr_result)
+  {
+    RunScript();
+  }
+
+  if (poll_active)
+  {
+    RunPoll();
+  }
 }
 
 bool TUioI2cCtrl::prfn_I2cControl(TUdoRequest * rq, TParamRangeDef * prdef)
@@ -106,6 +398,14 @@ bool TUioI2cCtrl::prfn_I2cControl(TUdoRequest * rq, TParamRangeDef * prdef)
 
   if (0x00 == idx) // I2C Speed
   {
+    if (rq->iswrite)
+    {
+      uint32_t v = udorq_uintvalue(rq);
+      if (v && (v < UIO_I2C_SPEED_MIN))
+      {
+        return udo_response_error(rq, UDOERR_WRITE_VALUE);
+      }
+    }
     return udo_rw_data(rq, &i2c_speed, sizeof(i2c_speed));
   }
   else if (0x01 == idx) // I2C EADDR (Extra Address)
@@ -133,6 +433,110 @@ bool TUioI2cCtrl::prfn_I2cControl(TUdoRequest * rq, TParamRangeDef * prdef)
   {
     return udo_rw_data(rq, &i2c_data_offs, sizeof(i2c_data_offs));
   }
+  else if (0x05 == idx) // I2C script MPRAM offset
+  {
+    return udo_rw_data(rq, &scr_offs, sizeof(scr_offs));
+  }
+  else if (0x06 == idx) // I2C script operation count
+  {
+    return udo_rw_data(rq, &scr_cnt, sizeof(scr_cnt));
+  }
+  else if (0x07 == idx) // I2C script start (write 1) / result (0xFFFF = running)
+  {
+    if (rq->iswrite)
+    {
+      if (1 != udorq_uintvalue(rq))
+      {
+        return udo_response_error(rq, UDOERR_WRITE_VALUE);
+      }
+      uint16_t err = ScriptStart();
+      return udo_response_error(rq, err);
+    }
+    return udo_ro_uint(rq, scr_result, 2);
+  }
+  else if (0x08 == idx) // I2C script executed steps, or the index of the failing step
+  {
+    return udo_ro_uint(rq, scr_idx, 2);
+  }
+  else if (0x18 == idx) // I2C bus statistics: recoveries, re-inits, timeouts, write resets
+  {
+    if (rq->iswrite)
+    {
+      if (2 == udorq_uintvalue(rq))  // manual bus recovery
+      {
+        if (Busy())
+        {
+          return udo_response_error(rq, UDOERR_BUSY);
+        }
+        BusRecovery();
+        return udo_response_ok(rq);
+      }
+      recovery_cnt = 0;
+      reinit_cnt = 0;
+      timeout_cnt = 0;
+      return udo_response_ok(rq);
+    }
+    uint32_t st[3] = { recovery_cnt, reinit_cnt, timeout_cnt };
+    return udo_ro_data(rq, &st[0], sizeof(st));
+  }
+  else if (0x19 == idx) // I2C transaction duration in us: last, max, write resets the max
+  {
+    if (rq->iswrite)
+    {
+      tra_max_us = 0;
+      return udo_response_ok(rq);
+    }
+    uint32_t st[2] = { tra_last_us, tra_max_us };
+    return udo_ro_data(rq, &st[0], sizeof(st));
+  }
+  else if (0x10 == idx) // I2C polling period in us
+  {
+    return udo_rw_data(rq, &poll_period_us, sizeof(poll_period_us));
+  }
+  else if (0x11 == idx) // I2C polling start (1) / stop (0)
+  {
+    if (rq->iswrite)
+    {
+      uint32_t rv32 = udorq_uintvalue(rq);
+      if (0 == rv32)
+      {
+        poll_active = false;  // a running script is finished normally
+        poll_running = false;
+        return udo_response_ok(rq);
+      }
+      else if (1 == rv32)
+      {
+        uint16_t err = PollStart();
+        return udo_response_error(rq, err);
+      }
+      return udo_response_error(rq, UDOERR_WRITE_VALUE);
+    }
+    return udo_ro_uint(rq, poll_active, 1);
+  }
+  else if (0x12 == idx) // I2C polling slots MPRAM offset
+  {
+    return udo_rw_data(rq, &poll_slot_offs, sizeof(poll_slot_offs));
+  }
+  else if (0x13 == idx) // I2C polling result data MPRAM offset (stored by the script)
+  {
+    return udo_rw_data(rq, &poll_src_offs, sizeof(poll_src_offs));
+  }
+  else if (0x14 == idx) // I2C polling result data length
+  {
+    return udo_rw_data(rq, &poll_len, sizeof(poll_len));
+  }
+  else if (0x15 == idx) // I2C polling status: sequence, error count, last error (step << 16 | error), missed periods
+  {
+    if (rq->iswrite)  // reset the error counters
+    {
+      poll_errcnt = 0;
+      poll_lasterr = 0;
+      poll_latecnt = 0;
+      return udo_response_ok(rq);
+    }
+    uint32_t st[4] = { poll_seq, poll_errcnt, poll_lasterr, poll_latecnt };
+    return udo_ro_data(rq, &st[0], sizeof(st));
+  }
 
   return udo_response_error(rq, UDOERR_INDEX);
 }
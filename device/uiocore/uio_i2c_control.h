@@ -33,11 +33,31 @@
 #include "udoslave.h"
 #include "simple_partable.h"
 
+#include "hwpins.h"
 #include "hwi2c.h"
 #include "hwdma.h"
 
 #include "uio_common.h"
 
+#define UIO_I2C_SCRIPT_MAX      256
+#define UIO_I2C_SPEED_MIN       1000     // 0 = not configured
+
+#define UIO_I2C_ERR_TIMEOUT     0x00FE  // transaction result code at timeout
+
+#define UIO_I2CSCR_FLAG_WRITE   (1 << 0)
+#define UIO_I2CSCR_EALEN_SHIFT  4        // bits 4-5: extra address length (0-3)
+
+typedef struct  // I2C script operation in the MPRAM
+{
+  uint8_t           addr;       // 7-bit device address
+  uint8_t           flags;      // UIO_I2CSCR_FLAG_*, extra address length
+  uint16_t          len;        // 0 = delay only
+  uint32_t          eaddr;      // extra address (register address)
+  uint16_t          data_offs;  // MPRAM offset of the data
+  uint16_t          delay_us;   // delay after the operation
+//
+} TUioI2cScriptOp;  // 12 bytes
+
 class TUioDevBase;
 
 class TUioI2cCtrl : public TClass
@@ -54,9 +74,58 @@ public:
   uint16_t          i2c_trlen = 0;
   uint16_t          i2c_result = 0;
 
+  // bus state and statistics
+  bool              reinit_required = true;   // after errors
+  TGpioPin *        scl_pin = nullptr;        // set by the board for the bus recovery
+  TGpioPin *        sda_pin = nullptr;
+  unsigned          scl_pinflags = 0;         // the normal (I2C) pin settings
+  unsigned          sda_pinflags = 0;
+  uint32_t          recovery_cnt = 0;
+  uint32_t          reinit_cnt = 0;
+  uint32_t          timeout_cnt = 0;
+  unsigned          tra_start_time = 0;
+  unsigned          tra_timeout_clocks = 0;
+  uint32_t          tra_last_us = 0;          // duration of the last transaction
+  uint32_t          tra_max_us = 0;
+
+  // script mode
+  uint16_t          scr_offs = 0;
+  uint16_t          scr_cnt = 0;
+  uint16_t          scr_idx = 0;        // executed steps, or the index of the failing step
+  uint16_t          scr_result = 0;     // 0xFFFF = running
+  uint8_t           scr_state = 0;
+  unsigned          scr_delay_start = 0;
+  unsigned          scr_delay_clocks = 0;
+
+  // periodic polling: the script is executed periodically, and the result data
+  // is copied into ping-pong MPRAM slots: [u32 sequence][data], slot = sequence & 1,
+  // the slot size is rounded up to 4 bytes, so the sequence numbers are aligned
+  uint32_t          poll_period_us = 100000;
+  uint16_t          poll_slot_offs = 0;
+  uint16_t          poll_src_offs = 0;   // result data, where the script stores it
+  uint16_t          poll_len = 0;
+  bool              poll_active = false;
+  bool              poll_running = false;  // the script was started by the polling
+  uint32_t          poll_seq = 0;        // completed polls
+  uint32_t          poll_errcnt = 0;
+  uint32_t          poll_lasterr = 0;
+  uint32_t          poll_latecnt = 0;    // missed periods
+  unsigned          poll_period_clocks = 0;
+  unsigned          poll_next_time = 0;
+
   void              Init(TUioDevBase * adevbase, THwI2c * ai2c);
   void              Run();
+  uint16_t          PollStart();
+  unsigned          PollSlotSize() { return ((4 + poll_len + 3) & ~3); }
+  void              RunPoll();
+  bool              Busy() { return ((0xFFFF == i2c_result) || (0xFFFF == scr_result) || !i2ctra.completed); }
+  void              PrepareBus();
+  void              BusRecovery();
+  bool              TransactionFinished();  // also handles the timeout
+  void              StartOp(uint8_t aaddr, uint32_t aeaddr, uint8_t aealen, bool awrite, uint8_t * adata, uint16_t alen);
   uint16_t          I2cStart();
+  uint16_t          ScriptStart();
+  void              RunScript();
   bool              prfn_I2cControl(TUdoRequest * rq, TParamRangeDef * prdef);
 
 };
@@ -34,13 +34,24 @@
 
 TUioNvData g_nvdata;
 
-#if HAS_SPI_FLASH
+static inline void nvkv_read(unsigned addr, void * dst, unsigned len)
+{
+  #if HAS_SPI_FLASH
+    g_nvstorage.Read(addr, dst, len);  // waits for the queued jobs
+  #else
+    memcpy(dst, (void *)addr, len);
+  #endif
+}
 
-  // with SPI Flash storage the CPU must have enough RAM to have this relative big buffer
+static inline unsigned nvkv_recsize(unsigned alen)
+{
+  return sizeof(TUioNvKvRec) + ((alen + 7) & ~7);
+}
 
-  // this two sector buffer mirrors the SPI Flash content:
-  uint8_t nvdata_spi_buf[8192] __attribute__((aligned(8)));
-#endif
+static inline unsigned nvkv_hash(uint16_t aid)
+{
+  return ((aid * 2654435761u) >> 16) & (UIO_NVKV_HASH_SIZE - 1);
+}
 
 void TUioNvData::Init()
 {
@@ -51,157 +62,545 @@ void TUioNvData::Init()
     g_nvstorage.Init();
   }
 
+  initializing = true;  // blocking flash operations
+
   sector_size = g_uiodev.nvs_sector_size;
   nvsaddr_base = g_uiodev.nvsaddr_nvdata;
+  n = (g_uiodev.nvs_nvdata_size ? g_uiodev.nvs_nvdata_size / sector_size : 2);
+  if (n < 2)  n = 2;
+  if (n > UIO_NVKV_MAX_SECTORS)  n = UIO_NVKV_MAX_SECTORS;
+  sector_cnt = n;
+
+  key_cnt = 0;
+  live_bytes = 0;
+  memset(&keyhash[0], 0, sizeof(keyhash));
+
+  // check the sector headers
+  uint8_t legacy_mask = 0;
+  TUioNvKvSecHead  sh;
+  for (n = 0; n < sector_cnt; ++n)
+  {
+    nvkv_read(nvsaddr_base + n * sector_size, &sh, sizeof(sh));
+    if ((n < UIO_NVDATA_SECTORS) && (UIO_NVDATA_SIGNATURE == sh.signature))
+    {
+      legacy_mask |= (1 << n);
+    }
 
-  chrec_count = (sector_size - sizeof(TUioNvDataHead)) / sizeof(TUioNvDataChRec);
+    sec_erase_cnt[n] = 0;
+    sec_seq[n] = 0;
+    if (UIO_NVKV_SIGNATURE != sh.signature)
+    {
+      sec_state[n] = UIO_NVKV_SEC_UNKNOWN;
+    }
+    else
+    {
+      sec_erase_cnt[n] = sh.erase_cnt;
+      if ((0xFFFFFFFF == sh.seq) && (0xFFFFFFFF == sh.seq_not))
+      {
+        sec_state[n] = UIO_NVKV_SEC_FREE;
+      }
+      else if (sh.seq == (sh.seq_not ^ 0xFFFFFFFF))
+      {
+        sec_state[n] = UIO_NVKV_SEC_USED;
+        sec_seq[n] = sh.seq;
+      }
+      else
+      {
+        sec_state[n] = UIO_NVKV_SEC_UNKNOWN;  // interrupted sector activation
+      }
+    }
+  }
 
-  #if HAS_SPI_FLASH
-    // load the two sectors into the memory first, the sector size must be 4096 here
+  bool legacy = (0 != legacy_mask);
+  if (legacy)
+  {
+    // the newer legacy sector holds the values, it is erased only after the migrated values are stored,
+    // the older one is free for the migration
+    uint8_t lsec = LoadLegacy();  // into the value[]
+    for (n = 0; n < UIO_NVDATA_SECTORS; ++n)
+    {
+      if (n == lsec)
+      {
+        sec_state[n] = UIO_NVKV_SEC_LEGACY;
+      }
+      else if (legacy_mask & (1 << n))
+      {
+        sec_state[n] = UIO_NVKV_SEC_UNKNOWN;
+      }
+    }
+  }
 
-    g_nvstorage.Read(nvsaddr_base, &nvdata_spi_buf[0], sizeof(nvdata_spi_buf));
+  for (n = 0; n < sector_cnt; ++n)
+  {
+    if (UIO_NVKV_SEC_UNKNOWN == sec_state[n])
+    {
+      FormatSector(n);
+    }
+  }
 
-    TUioNvDataHead *  phead1 = (TUioNvDataHead *)&nvdata_spi_buf[0 * sector_size];
-    TUioNvDataHead *  phead2 = (TUioNvDataHead *)&nvdata_spi_buf[1 * sector_size];
-  #else
-    // two sectors, select the newer one
+  // replay the used sectors in the log order, the later records override the earlier ones
+  next_seq = 1;
+  head_sector = 0xFF;
+  while (true)
+  {
+    uint8_t sidx = 0xFF;
+    for (n = 0; n < sector_cnt; ++n)
+    {
+      if ((UIO_NVKV_SEC_USED == sec_state[n]) && (sec_seq[n] >= next_seq)
+          && ((0xFF == sidx) || (sec_seq[n] < sec_seq[sidx])))
+      {
+        sidx = n;
+      }
+    }
+    if (0xFF == sidx)
+    {
+      break;
+    }
+    ScanSector(sidx);  // sets the head_offs
+    head_sector = sidx;
+    next_seq = sec_seq[sidx] + 1;
+  }
 
-    TUioNvDataHead *  phead1 = (TUioNvDataHead *)(nvsaddr_base + 0 * sector_size);
-    TUioNvDataHead *  phead2 = (TUioNvDataHead *)(nvsaddr_base + 1 * sector_size);
-  #endif
+  // the migrated values are stored in the id order, so the last one shows a completed migration
+  bool migrate = (legacy && !FindKey(UIO_NVDATA_COUNT - 1));
+  if (migrate)
+  {
+    // drop the records of an interrupted migration
+    for (n = 0; n < sector_cnt; ++n)
+    {
+      if (UIO_NVKV_SEC_USED == sec_state[n])
+      {
+        FormatSector(n);
+      }
+    }
+    key_cnt = 0;
+    live_bytes = 0;
+    memset(&keyhash[0], 0, sizeof(keyhash));
+    head_sector = 0xFF;
+  }
 
-  TUioNvDataHead *   phead = nullptr;
+  if (0xFF == head_sector)  // empty store
+  {
+    NextHeadSector(true);
+  }
 
-  if (UIO_NVDATA_SIGNATURE == phead1->signature)
+  if (migrate)  // store the migrated values
   {
-    phead = phead1;
-    sector_index = 0;
+    for (n = 0; n < UIO_NVDATA_COUNT; ++n)
+    {
+      TUioNvKvKey * pkey = AddKey(n);
+      pkey->len = 4;
+      memcpy(&pkey->data[0], &value[n], 4);
+      if (head_offs + nvkv_recsize(4) > sector_size)
+      {
+        NextHeadSector(true);
+      }
+      AppendRecord(pkey);
+      live_bytes += nvkv_recsize(4);
+    }
   }
 
-  if (UIO_NVDATA_SIGNATURE == phead2->signature)
+  for (n = 0; n < sector_cnt; ++n)  // the legacy sectors are not needed anymore
   {
-    if (!phead || (phead->serial < phead2->serial))
+    if (UIO_NVKV_SEC_LEGACY == sec_state[n])
     {
-      phead = phead2;
-      sector_index = 1;
+      FormatSector(n);
     }
   }
 
-  TUioNvDataHead  ldatahead;
+  for (n = 0; n < UIO_NVDATA_COUNT; ++n)
+  {
+    TUioNvKvKey * pkey = FindKey(n);
+    value[n] = ((pkey && (4 == pkey->len)) ? *(uint32_t *)&pkey->data[0] : 0);
+  }
+
+  initializing = false;
+}
 
+uint8_t TUioNvData::LoadLegacy()
+{
+  // two sectors, select the newer one
+  TUioNvDataHead  head1;
+  TUioNvDataHead  head2;
+  nvkv_read(nvsaddr_base + 0 * sector_size, &head1, sizeof(head1));
+  nvkv_read(nvsaddr_base + 1 * sector_size, &head2, sizeof(head2));
+
+  TUioNvDataHead *  phead = nullptr;
+  unsigned          sidx = 0;
+  if (UIO_NVDATA_SIGNATURE == head1.signature)
+  {
+    phead = &head1;
+  }
+  if ((UIO_NVDATA_SIGNATURE == head2.signature) && (!phead || (phead->serial < head2.serial)))
+  {
+    phead = &head2;
+    sidx = 1;
+  }
   if (!phead)
   {
-    // not initialized yet
+    return 0xFF;
+  }
 
-    g_nvstorage.Erase(nvsaddr_base, sector_size * 2);
+  // load the initial data
+  memcpy(&value[0], &phead->value[0], sizeof(value));
 
-    ldatahead.signature = UIO_NVDATA_SIGNATURE;
-    ldatahead.serial = 1;
-    memcpy(&ldatahead.value[0], &value[0], sizeof(value));
+  // process the change recs
+  unsigned chrec_count = (sector_size - sizeof(TUioNvDataHead)) / sizeof(TUioNvDataChRec);
+  unsigned addr = nvsaddr_base + sidx * sector_size + sizeof(TUioNvDataHead);
+  TUioNvDataChRec  rec;
+  for (unsigned n = 0; n < chrec_count; ++n)
+  {
+    nvkv_read(addr, &rec, sizeof(rec));
+    if ((rec.id != (rec.id_not ^ 0xFF)) || (rec.id >= UIO_NVDATA_COUNT))
+    {
+      break;
+    }
+    value[rec.id] = rec.value;
+    addr += sizeof(rec);
+  }
 
-    g_nvstorage.Write(nvsaddr_base, &ldatahead,  sizeof(ldatahead));
+  return sidx;
+}
 
-    sector_index = 0;
+void TUioNvData::FormatSector(uint8_t asector)
+{
+  TUioNvKvSecHead  sh;
+  sh.signature = UIO_NVKV_SIGNATURE;
+  sh.erase_cnt = sec_erase_cnt[asector] + 1;
 
-    #if HAS_SPI_FLASH
-      // update the local buffer
-      memset(&nvdata_spi_buf[0], 0xFF, sizeof(nvdata_spi_buf));
-      memcpy(&nvdata_spi_buf[0], &ldatahead,  sizeof(ldatahead));
-    #endif
-  }
-  else
+  unsigned addr = nvsaddr_base + asector * sector_size;
+  FlashErase(addr, sector_size);
+  FlashWrite(addr, &sh, 8);  // the seq remains erased
+
+  sec_erase_cnt[asector] = sh.erase_cnt;
+  sec_state[asector] = UIO_NVKV_SEC_FREE;
+}
+
+void TUioNvData::ScanSector(uint8_t asector)
+{
+  TUioNvKvRec  rec;
+  uint8_t      data[UIO_NVKV_MAX_LEN] __attribute__((aligned(4)));
+  unsigned     secaddr = nvsaddr_base + asector * sector_size;
+  unsigned     offs = sizeof(TUioNvKvSecHead);
+
+  while (offs + sizeof(rec) <= sector_size)
   {
-    // load the initial data
-    memcpy(&value[0], &phead->value[0], sizeof(value));
+    nvkv_read(secaddr + offs, &rec, sizeof(rec));
+    if (UIO_NVKV_ID_EMPTY == rec.id)
+    {
+      break;  // end of the log
+    }
 
-    // process the change recs
-    TUioNvDataChRec *  prec = (TUioNvDataChRec *)(phead + 1);  // the first changerec follows the header
-    n = 0;
-    while (n < chrec_count)
+    unsigned recsize = nvkv_recsize(rec.len);
+    if ((rec.len != (rec.len_not ^ 0xFF)) || (rec.len > UIO_NVKV_MAX_LEN) || (offs + recsize > sector_size))
     {
-      if ((prec->id == (prec->id_not ^ 0xFF)) && (prec->id >= 0) && (prec->id < UIO_NVDATA_COUNT))
+      offs = sector_size;  // corrupted, do not write here anymore
+      break;
+    }
+
+    nvkv_read(secaddr + offs + sizeof(rec), &data[0], rec.len);
+    uint32_t crc = uio_crc32(0, &rec, 4);
+    crc = uio_crc32(crc, &data[0], rec.len);
+    if (crc == rec.crc)
+    {
+      TUioNvKvKey * pkey = FindKey(rec.id);
+      if (pkey)
       {
-        value[prec->id] = prec->value;
+        live_bytes -= nvkv_recsize(pkey->len);
       }
       else
       {
-        break;
+        pkey = AddKey(rec.id);
+      }
+
+      if (pkey)
+      {
+        pkey->len = rec.len;
+        pkey->addr = secaddr + offs;
+        memcpy(&pkey->data[0], &data[0], rec.len);
+        live_bytes += recsize;
       }
-      ++prec;
-      ++n;
     }
+
+    offs += recsize;
   }
+
+  head_offs = offs;
 }
 
-uint16_t TUioNvData::SaveValue(uint8_t aid, uint32_t avalue)
+TUioNvKvKey * TUioNvData::FindKey(uint16_t aid)
+{
+  unsigned h = nvkv_hash(aid);
+  while (keyhash[h])
+  {
+    TUioNvKvKey * pkey = &keys[keyhash[h] - 1];
+    if (pkey->id == aid)
+    {
+      return pkey;
+    }
+    h = ((h + 1) & (UIO_NVKV_HASH_SIZE - 1));
+  }
+  return nullptr;
+}
+
+TUioNvKvKey * TUioNvData::AddKey(uint16_t aid)
+{
+  if (key_cnt >= UIO_NVKV_MAX_KEYS)
+  {
+    return nullptr;
+  }
+
+  unsigned h = nvkv_hash(aid);
+  while (keyhash[h])
+  {
+    h = ((h + 1) & (UIO_NVKV_HASH_SIZE - 1));
+  }
+
+  TUioNvKvKey * pkey = &keys[key_cnt];
+  ++key_cnt;
+  keyhash[h] = key_cnt;
+
+  pkey->id = aid;
+  pkey->len = 0;
+  pkey->addr = 0;
+  return pkey;
+}
+
+unsigned TUioNvData::FreeCount()
+{
+  unsigned cnt = 0;
+  for (unsigned n = 0; n < sector_cnt; ++n)
+  {
+    if (UIO_NVKV_SEC_FREE == sec_state[n])  ++cnt;
+  }
+  return cnt;
+}
+
+unsigned TUioNvData::UsedCount()
+{
+  unsigned cnt = 0;
+  for (unsigned n = 0; n < sector_cnt; ++n)
+  {
+    if (UIO_NVKV_SEC_USED == sec_state[n])  ++cnt;
+  }
+  return cnt;
+}
+
+bool TUioNvData::NextHeadSector(bool acompaction)
+{
+  // the last free sector is reserved for the compaction
+  if ((0 == FreeCount()) || ((FreeCount() < 2) && !acompaction))
+  {
+    return false;
+  }
+
+  // the next free sector in the ring order spreads the wear
+  uint8_t sidx = (0xFF == head_sector ? 0 : head_sector);
+  do
+  {
+    ++sidx;
+    if (sidx >= sector_cnt)  sidx = 0;
+  }
+  while (UIO_NVKV_SEC_FREE != sec_state[sidx]);
+
+  uint32_t seqw[2] = {next_seq, next_seq ^ 0xFFFFFFFF};
+  FlashWrite(nvsaddr_base + sidx * sector_size + 8, &seqw[0], 8);
+
+  sec_state[sidx] = UIO_NVKV_SEC_USED;
+  sec_seq[sidx] = next_seq;
+  ++next_seq;
+  head_sector = sidx;
+  head_offs = sizeof(TUioNvKvSecHead);
+  return true;
+}
+
+void TUioNvData::AppendRecord(TUioNvKvKey * pkey)
+{
+  uint8_t  recbuf[sizeof(TUioNvKvRec) + UIO_NVKV_MAX_LEN] __attribute__((aligned(4)));
+  unsigned recsize = nvkv_recsize(pkey->len);
+
+  memset(&recbuf[0], 0xFF, recsize);
+  TUioNvKvRec * prec = (TUioNvKvRec *)&recbuf[0];
+  prec->id = pkey->id;
+  prec->len = pkey->len;
+  prec->len_not = (pkey->len ^ 0xFF);
+  memcpy(&recbuf[sizeof(TUioNvKvRec)], &pkey->data[0], pkey->len);
+  uint32_t crc = uio_crc32(0, prec, 4);
+  prec->crc = uio_crc32(crc, &pkey->data[0], pkey->len);
+
+  pkey->addr = nvsaddr_base + head_sector * sector_size + head_offs;
+  FlashWrite(pkey->addr, &recbuf[0], recsize);  // the job copies the record
+  head_offs += recsize;
+}
+
+uint16_t TUioNvData::SetValue(uint16_t aid, void * adata, unsigned alen)
 {
   if (lock != UIO_NVDATA_UNLOCK)
   {
     return UDOERR_READ_ONLY;
   }
 
-  aid = (aid & 0x1F);  // ensure safe index
-
-  if (value[aid] == avalue)
+  if ((UIO_NVKV_ID_EMPTY == aid) || (alen > UIO_NVKV_MAX_LEN))
   {
-    return 0;
+    return UDOERR_WRITE_VALUE;
   }
 
-  value[aid] = avalue; // update locally first
+  TUioNvKvKey * pkey = FindKey(aid);
+  if (pkey && (pkey->len == alen) && (0 == memcmp(&pkey->data[0], adata, alen)))
+  {
+    return 0;  // unchanged
+  }
 
-  #if HAS_SPI_FLASH
-    TUioNvDataHead *  phead = (TUioNvDataHead *)&nvdata_spi_buf[sector_size * sector_index];
-    uint8_t * pbase = (uint8_t *)&nvdata_spi_buf[0];
-  #else
-    TUioNvDataHead *  phead = (TUioNvDataHead *)(nvsaddr_base + sector_size * sector_index);
-    uint8_t * pbase = (uint8_t *)nvsaddr_base;
-  #endif
+  // the live data must fit into the sectors besides the compaction reserve
+  unsigned recsize = nvkv_recsize(alen);
+  unsigned oldsize = (pkey ? nvkv_recsize(pkey->len) : 0);
+  unsigned capacity = (sector_cnt - 1) * (sector_size - sizeof(TUioNvKvSecHead)) - nvkv_recsize(UIO_NVKV_MAX_LEN);
+  if ((!pkey && (key_cnt >= UIO_NVKV_MAX_KEYS)) || (live_bytes - oldsize + recsize > capacity))
+  {
+    return UDOERR_WRITE_VALUE;
+  }
 
-  // search an empty (0xFF) record
+  // the flash operations are queued, the Run() of the g_nvstorage executes them
+  if (!g_nvstorage.JobsFree(2) || (cmp_active && (0 == FreeCount())))
+  {
+    return UDOERR_BUSY;  // the rest of the head sector belongs to the running compaction
+  }
 
-  TUioNvDataChRec *  prec = (TUioNvDataChRec *)(phead + 1);  // the address after the header
-  unsigned n = 0;
-  while (n < chrec_count)
+  if (head_offs + recsize > sector_size)
   {
-    if ((0xFF == prec->id) && (0xFF == prec->id_not) && (0xFFFFFFFF == prec->value))
+    if (!NextHeadSector(false))
     {
-      // found an empty record, write there
+      return UDOERR_BUSY;  // the compaction must free a sector first
+    }
+  }
 
-      TUioNvDataChRec lrec;
-      memset(&lrec, 0xFF, sizeof(lrec));
-      lrec.id = aid;
-      lrec.id_not = (aid ^ 0xFF);
-      lrec.value = avalue;
+  if (!pkey)
+  {
+    pkey = AddKey(aid);
+  }
 
-      g_nvstorage.Write(nvsaddr_base + unsigned(prec) - unsigned(pbase), &lrec,  sizeof(lrec));
-      #if HAS_SPI_FLASH
-        // update the local buffer too, the prec points there
-        memcpy(prec, &lrec,  sizeof(lrec));
-      #endif
+  live_bytes = live_bytes - oldsize + recsize;
+  pkey->len = alen;
+  memcpy(&pkey->data[0], adata, alen);
+  AppendRecord(pkey);
 
-      return 0;
-    }
-    ++prec;
-    ++n;
+  if ((aid < UIO_NVDATA_COUNT) && (4 == alen))
+  {
+    value[aid] = *(uint32_t *)&pkey->data[0];
   }
 
-  // no empty record was found, erase the other sector and write there
+  return 0;
+}
 
-  TUioNvDataHead  ldatahead;
-  ldatahead.signature = UIO_NVDATA_SIGNATURE;
-  ldatahead.serial = phead->serial + 1;
-  memcpy(&ldatahead.value[0], &value[0], sizeof(value));
+uint16_t TUioNvData::SaveValue(uint8_t aid, uint32_t avalue)
+{
+  aid = (aid & 0x1F);  // ensure safe index
+  return SetValue(aid, &avalue, 4);
+}
 
-  sector_index = (sector_index ^ 1); // change to the other sector
+void TUioNvData::Run()
+{
+  if (!cmp_active)
+  {
+    if (FreeCount() > 1)
+    {
+      return;
+    }
 
-  g_nvstorage.Erase(nvsaddr_base + sector_size * sector_index, sector_size);
-  g_nvstorage.Write(nvsaddr_base + sector_size * sector_index, &ldatahead,  sizeof(ldatahead));
+    // compact the oldest used sector
+    uint8_t sidx = 0xFF;
+    for (unsigned n = 0; n < sector_cnt; ++n)
+    {
+      if ((UIO_NVKV_SEC_USED == sec_state[n]) && ((0xFF == sidx) || (sec_seq[n] < sec_seq[sidx])))
+      {
+        sidx = n;
+      }
+    }
+
+    if (sidx == head_sector)
+    {
+      // only the head is used: compact it only when it is nearly full
+      if ((head_offs + nvkv_recsize(UIO_NVKV_MAX_LEN) <= sector_size) || !NextHeadSector(true))
+      {
+        return;
+      }
+    }
+
+    cmp_sector = sidx;
+    cmp_offs = sizeof(TUioNvKvSecHead);
+    cmp_active = true;
+    return;
+  }
+
+  if (!g_nvstorage.JobsFree(3))
+  {
+    return;
+  }
 
   #if HAS_SPI_FLASH
-    // update the local buffer too
-    memset(&nvdata_spi_buf[sector_size * sector_index], 0xFF, sector_size);
-    memcpy(&nvdata_spi_buf[sector_size * sector_index], &ldatahead,  sizeof(ldatahead));
+    if (g_nvstorage.Busy())
+    {
+      return;  // the SPI flash read would wait for the queued jobs
+    }
   #endif
 
-  return 0;
+  // one record per call, the live ones are copied to the head from the RAM index
+  TUioNvKvRec  rec;
+  unsigned     secaddr = nvsaddr_base + cmp_sector * sector_size;
+  rec.id = UIO_NVKV_ID_EMPTY;
+  if (cmp_offs + sizeof(rec) <= sector_size)
+  {
+    nvkv_read(secaddr + cmp_offs, &rec, sizeof(rec));
+  }
+
+  if ((UIO_NVKV_ID_EMPTY == rec.id) || (rec.len != (rec.len_not ^ 0xFF)) || (rec.len > UIO_NVKV_MAX_LEN))
+  {
+    // the sector is processed, erase it
+    FormatSector(cmp_sector);
+    ++compactions;
+    cmp_active = false;
+    return;
+  }
+
+  unsigned recsize = nvkv_recsize(rec.len);
+  TUioNvKvKey * pkey = FindKey(rec.id);
+  if (pkey && (pkey->addr == secaddr + cmp_offs))
+  {
+    if (head_offs + recsize > sector_size)
+    {
+      if (!NextHeadSector(true))
+      {
+        return;  // should not happen, the capacity is limited at the SetValue
+      }
+    }
+    AppendRecord(pkey);
+  }
+
+  cmp_offs += recsize;
+}
+
+void TUioNvData::GetStatus(TUioNvKvStatus * rstatus)
+{
+  rstatus->sector_cnt = sector_cnt;
+  rstatus->free_cnt = FreeCount();
+  rstatus->key_cnt = key_cnt;
+  rstatus->head_sector = head_sector;
+  rstatus->live_bytes = live_bytes;
+  rstatus->compactions = compactions;
+}
+
+void TUioNvData::FlashWrite(unsigned addr, void * src, unsigned len)
+{
+  if (initializing || !g_nvstorage.AddJob(UIO_NVS_JOB_WRITE, addr, src, len))
+  {
+    g_nvstorage.Write(addr, src, len);
+  }
+}
+
+void TUioNvData::FlashErase(unsigned addr, unsigned len)
+{
+  if (initializing || !g_nvstorage.AddJob(UIO_NVS_JOB_ERASE, addr, nullptr, len))
+  {
+    g_nvstorage.Erase(addr, len);
+  }
 }
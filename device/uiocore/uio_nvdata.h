@@ -31,11 +31,32 @@
 
 #include "stdint.h"
 
+// legacy two sector format, migrated at the first start
 #define UIO_NVDATA_SIGNATURE  0x55AAAA55
 #define UIO_NVDATA_SECTORS             2
 #define UIO_NVDATA_COUNT              32
 #define UIO_NVDATA_UNLOCK     0x5ADEC0DE
 
+// log-structured key / value store over N sectors
+#define UIO_NVKV_SIGNATURE    0x4B564E55  // "UNVK"
+
+#ifndef UIO_NVKV_MAX_SECTORS
+  #define UIO_NVKV_MAX_SECTORS  16
+#endif
+#ifndef UIO_NVKV_MAX_KEYS
+  #define UIO_NVKV_MAX_KEYS     64
+#endif
+#ifndef UIO_NVKV_MAX_LEN
+  #define UIO_NVKV_MAX_LEN      32   // the values are cached in the RAM index
+#endif
+#define UIO_NVKV_HASH_SIZE    (2 * UIO_NVKV_MAX_KEYS)  // power of 2
+#define UIO_NVKV_ID_EMPTY     0xFFFF
+
+#define UIO_NVKV_SEC_UNKNOWN  0
+#define UIO_NVKV_SEC_FREE     1    // erased and formatted
+#define UIO_NVKV_SEC_USED     2
+#define UIO_NVKV_SEC_LEGACY   3    // old format, kept until the migrated values are stored
+
 typedef struct
 {
   uint8_t     id;
@@ -53,20 +74,96 @@ typedef struct
 //
 } TUioNvDataHead;
 
+// Sector header, programmed in two 8-byte steps: after the erase and when the sector becomes the log head
+typedef struct
+{
+  uint32_t    signature;
+  uint32_t    erase_cnt;
+  uint32_t    seq;        // log order of the used sectors, 0xFFFFFFFF = free
+  uint32_t    seq_not;
+//
+} TUioNvKvSecHead; // 16 bytes
+
+// Record header, followed by the data padded to 8 bytes
+typedef struct
+{
+  uint16_t    id;         // 0xFFFF = end of the log in the sector
+  uint8_t     len;
+  uint8_t     len_not;
+  uint32_t    crc;        // CRC32 of the first 4 bytes and the data
+//
+} TUioNvKvRec; // 8 bytes
+
+typedef struct
+{
+  uint16_t    id;
+  uint8_t     len;
+  uint8_t     _reserved;
+  uint32_t    addr;       // flash address of the actual record
+  uint8_t     data[UIO_NVKV_MAX_LEN] __attribute__((aligned(4)));
+//
+} TUioNvKvKey;
+
+typedef struct
+{
+  uint16_t    sector_cnt;
+  uint16_t    free_cnt;
+  uint16_t    key_cnt;
+  uint16_t    head_sector;
+  uint32_t    live_bytes;
+  uint32_t    compactions;
+//
+} TUioNvKvStatus; // 16 bytes
+
 class TUioNvData
 {
 public:
   uint32_t     lock = 0;
   uint32_t     sector_size = 1024;  // will be adjusted to the erase size
   uint32_t     nvsaddr_base = 0;
+  uint8_t      sector_cnt = 2;
 
-  uint8_t      sector_index = 0;
-  uint16_t     chrec_count = 0;
-
-  uint32_t     value[UIO_NVDATA_COUNT] = {0};
+  uint32_t     value[UIO_NVDATA_COUNT] = {0};  // the legacy u32 values are the keys 0 - 31
 
   void         Init();
+  void         Run();  // background compaction
   uint16_t     SaveValue(uint8_t aid, uint32_t avalue);
+
+  uint16_t     SetValue(uint16_t aid, void * adata, unsigned alen);
+  TUioNvKvKey * FindKey(uint16_t aid);
+  void         GetStatus(TUioNvKvStatus * rstatus);
+
+public:
+  bool           initializing = false;
+  uint8_t        head_sector = 0;
+  uint32_t       head_offs = 0;
+  uint32_t       next_seq = 1;
+  uint32_t       live_bytes = 0;
+  uint32_t       compactions = 0;
+
+  uint8_t        sec_state[UIO_NVKV_MAX_SECTORS];
+  uint32_t       sec_seq[UIO_NVKV_MAX_SECTORS];
+  uint32_t       sec_erase_cnt[UIO_NVKV_MAX_SECTORS];
+
+  uint16_t       key_cnt = 0;
+  uint8_t        keyhash[UIO_NVKV_HASH_SIZE];   // key index + 1, 0 = empty
+  TUioNvKvKey    keys[UIO_NVKV_MAX_KEYS];
+
+  bool           cmp_active = false;
+  uint8_t        cmp_sector = 0;
+  uint32_t       cmp_offs = 0;
+
+protected:
+  uint8_t      LoadLegacy();  // returns the sector of the newer legacy data, 0xFF = none
+  void         FormatSector(uint8_t asector);
+  void         ScanSector(uint8_t asector);
+  bool         NextHeadSector(bool acompaction);
+  void         AppendRecord(TUioNvKvKey * pkey);
+  TUioNvKvKey * AddKey(uint16_t aid);
+  unsigned     FreeCount();
+  unsigned     UsedCount();
+  void         FlashWrite(unsigned addr, void * src, unsigned len);
+  void         FlashErase(unsigned addr, unsigned len);
 };
 
 extern TUioNvData g_nvdata;
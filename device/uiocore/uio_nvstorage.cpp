@@ -50,6 +50,8 @@ void TUioNvStorage::Erase(unsigned addr, unsigned len)
     return;
   }
 
+  WaitJobs();
+
   #if HAS_SPI_FLASH
     spiflash.StartEraseMem(addr, len);
     spiflash.WaitForComplete();
@@ -66,6 +68,8 @@ void TUioNvStorage::Write(unsigned addr, void * src, unsigned len)
     return;
   }
 
+  WaitJobs();
+
   #if HAS_SPI_FLASH
     spiflash.StartWriteMem(addr, src, len);
     spiflash.WaitForComplete();
@@ -82,6 +86,8 @@ void TUioNvStorage::CopyTo(unsigned addr, void * src, unsigned len)
     return;
   }
 
+  WaitJobs();
+
   #if HAS_SPI_FLASH
 
     uint8_t   localbuf[SPIFL_UPDATER_BUFSIZE] __attribute__((aligned(8)));
@@ -103,6 +109,8 @@ void TUioNvStorage::Read(unsigned addr, void * dst, unsigned len)
     return;
   }
 
+  WaitJobs();
+
   #if HAS_SPI_FLASH
     spiflash.StartReadMem(addr,  dst,  len);
     spiflash.WaitForComplete();
@@ -110,3 +118,197 @@ void TUioNvStorage::Read(unsigned addr, void * dst, unsigned len)
     memcpy(dst, (void *)addr, len);
   #endif
 }
+
+bool TUioNvStorage::JobsFree(unsigned acount)
+{
+  return (UIO_NVS_JOB_COUNT - 1 - ((job_wr - job_rd) & (UIO_NVS_JOB_COUNT - 1)) >= acount);
+}
+
+bool TUioNvStorage::AddJob(uint8_t atype, unsigned addr, void * src, unsigned len)
+{
+  if (!initialized || !JobsFree(1))
+  {
+    return false;
+  }
+
+  TUioNvsJob * pjob = &jobs[job_wr];
+  pjob->type = atype;
+  pjob->addr = addr;
+  pjob->len  = len;
+  if (src && (len <= UIO_NVS_JOB_DATALEN))
+  {
+    memcpy(&pjob->data[0], src, len);
+    pjob->src = &pjob->data[0];
+  }
+  else
+  {
+    pjob->src = src;
+  }
+
+  job_wr = ((job_wr + 1) & (UIO_NVS_JOB_COUNT - 1));
+  ++jobs_added;
+
+  Run();  // start it immediately when possible
+  return true;
+}
+
+bool TUioNvStorage::FlashCompleted()
+{
+  #if HAS_SPI_FLASH
+    if (!spiflash.completed)
+    {
+      spiflash.Run();
+    }
+    return spiflash.completed;
+  #else
+    if (!hwintflash.completed)
+    {
+      hwintflash.Run();
+    }
+    return hwintflash.completed;
+  #endif
+}
+
+void TUioNvStorage::StartJob(TUioNvsJob * pjob)
+{
+  #if HAS_SPI_FLASH
+    if (UIO_NVS_JOB_ERASE == pjob->type)
+    {
+      spiflash.StartEraseMem(pjob->addr, pjob->len);
+    }
+    else if (UIO_NVS_JOB_WRITE == pjob->type)
+    {
+      spiflash.StartWriteMem(pjob->addr, pjob->src, pjob->len);
+    }
+    else
+    {
+      // runs in steps from the Run(), writes only the changed sectors
+      copy_state = 0;
+      copy_offs = 0;
+      CopyStep(pjob);
+    }
+  #else
+    if (UIO_NVS_JOB_ERASE == pjob->type)
+    {
+      hwintflash.StartEraseMem(pjob->addr, pjob->len);
+    }
+    else if (UIO_NVS_JOB_WRITE == pjob->type)
+    {
+      hwintflash.StartWriteMem(pjob->addr, pjob->src, pjob->len);
+    }
+    else
+    {
+      hwintflash.StartCopyMem(pjob->addr, pjob->src, pjob->len);
+    }
+  #endif
+}
+
+#if HAS_SPI_FLASH
+
+bool TUioNvStorage::CopyStep(TUioNvsJob * pjob)
+{
+  uint8_t * src = (uint8_t *)pjob->src;
+
+  while (true)
+  {
+    if (0 == copy_state)  // start the next sector
+    {
+      if (copy_offs >= pjob->len)
+      {
+        return false;
+      }
+
+      unsigned secaddr = pjob->addr + copy_offs;
+      copy_seclen = UIO_NVS_COPY_SECTOR - (secaddr & (UIO_NVS_COPY_SECTOR - 1));
+      if (copy_seclen > pjob->len - copy_offs)
+      {
+        copy_seclen = pjob->len - copy_offs;
+      }
+      copy_cmp_offs = 0;
+      copy_state = 1;
+    }
+
+    if (1 == copy_state)  // read the next chunk for the compare
+    {
+      if (copy_cmp_offs >= copy_seclen)  // the sector is unchanged
+      {
+        copy_offs += copy_seclen;
+        copy_state = 0;
+        continue;
+      }
+
+      copy_cmp_len = copy_seclen - copy_cmp_offs;
+      if (copy_cmp_len > sizeof(copy_buf))
+      {
+        copy_cmp_len = sizeof(copy_buf);
+      }
+      spiflash.StartReadMem(pjob->addr + copy_offs + copy_cmp_offs, &copy_buf[0], copy_cmp_len);
+      copy_state = 2;
+      return true;
+    }
+
+    if (2 == copy_state)  // compare
+    {
+      if (0 == memcmp(&copy_buf[0], src + copy_offs + copy_cmp_offs, copy_cmp_len))
+      {
+        copy_cmp_offs += copy_cmp_len;
+        copy_state = 1;
+        continue;
+      }
+
+      spiflash.StartEraseMem(pjob->addr + copy_offs, copy_seclen);
+      copy_state = 3;
+      return true;
+    }
+
+    if (3 == copy_state)  // erased
+    {
+      spiflash.StartWriteMem(pjob->addr + copy_offs, src + copy_offs, copy_seclen);
+      copy_state = 4;
+      return true;
+    }
+
+    // 4: sector written
+    copy_offs += copy_seclen;
+    copy_state = 0;
+  }
+}
+
+#endif
+
+void TUioNvStorage::Run()
+{
+  if (job_running)
+  {
+    if (!FlashCompleted())
+    {
+      return;
+    }
+
+    #if HAS_SPI_FLASH
+      TUioNvsJob * pjob = &jobs[job_rd];
+      if ((UIO_NVS_JOB_COPY == pjob->type) && CopyStep(pjob))
+      {
+        return;  // next step started
+      }
+    #endif
+
+    job_running = false;
+    job_rd = ((job_rd + 1) & (UIO_NVS_JOB_COUNT - 1));
+    ++jobs_done;
+  }
+
+  if (job_rd != job_wr)
+  {
+    StartJob(&jobs[job_rd]);
+    job_running = true;
+  }
+}
+
+void TUioNvStorage::WaitJobs()
+{
+  while (Busy())
+  {
+    Run();
+  }
+}
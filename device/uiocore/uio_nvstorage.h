@@ -8,6 +8,29 @@
 #ifndef SRC_UIO_NVSTORAGE_H_
 #define SRC_UIO_NVSTORAGE_H_
 
+#include "stdint.h"
+
+#define UIO_NVS_JOB_ERASE     1
+#define UIO_NVS_JOB_WRITE     2
+#define UIO_NVS_JOB_COPY      3
+
+#define UIO_NVS_JOB_COUNT     8   // must be power of 2
+#define UIO_NVS_JOB_DATALEN  40   // smaller data is copied into the job (NV key/value records)
+
+// SPI flash copy jobs: compare, erase and write sector by sector without blocking
+#define UIO_NVS_COPY_SECTOR  4096  // erase unit, the copy target must be aligned to it
+#define UIO_NVS_COPY_CMPLEN  128   // compare chunk size
+
+typedef struct
+{
+  uint8_t      type;
+  uint32_t     addr;
+  uint32_t     len;
+  void *       src;     // points to data[] or to a buffer, that must be valid until the job is done
+  uint8_t      data[UIO_NVS_JOB_DATALEN] __attribute__((aligned(4)));
+//
+} TUioNvsJob;
+
 class TUioNvStorage
 {
 public:
@@ -18,6 +41,33 @@ public:
   void Write(unsigned addr, void * src, unsigned len);
   void CopyTo(unsigned addr, void * src, unsigned len);  // checks the previous contents first
   void Read(unsigned addr, void * dst, unsigned len);
+
+public: // asynchronous jobs, executed from the Run(), the blocking functions above wait for them first
+  TUioNvsJob   jobs[UIO_NVS_JOB_COUNT];
+  unsigned     job_rd = 0;
+  unsigned     job_wr = 0;
+  bool         job_running = false;
+  uint32_t     jobs_added = 0;
+  uint32_t     jobs_done = 0;
+
+  // SPI flash copy job state
+  uint8_t      copy_state = 0;
+  unsigned     copy_offs = 0;      // actual sector start relative to the job addr
+  unsigned     copy_seclen = 0;
+  unsigned     copy_cmp_offs = 0;  // compared bytes in the actual sector
+  unsigned     copy_cmp_len = 0;
+  uint8_t      copy_buf[UIO_NVS_COPY_CMPLEN] __attribute__((aligned(4)));
+
+  bool         AddJob(uint8_t atype, unsigned addr, void * src, unsigned len);
+  bool         JobsFree(unsigned acount);
+  bool         Busy() { return (job_rd != job_wr); }
+  void         Run();
+  void         WaitJobs();
+
+protected:
+  void         StartJob(TUioNvsJob * pjob);
+  bool         FlashCompleted();
+  bool         CopyStep(TUioNvsJob * pjob);  // false: the copy is finished
 };
 
 extern TUioNvStorage g_nvstorage;
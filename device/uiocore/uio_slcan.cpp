@@ -0,0 +1,428 @@
+/* -----------------------------------------------------------------------------
+ * This file is a part of the UNIVIO project: https://github.com/nvitya/univio
+ * Copyright (c) 2022 Viktor Nagy, nvitya
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from
+ * the use of this software. Permission is granted to anyone to use this
+ * software for any purpose, including commercial applications, and to alter
+ * it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software in
+ *    a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ * --------------------------------------------------------------------------- */
+/*
+ *  file:     uio_slcan.cpp
+ *  brief:    SLCAN (LAWICEL) ASCII protocol on a USB CDC function for the first CAN unit
+ *  date:     2026-10-19
+ *  authors:  nvitya
+*/
+
+#include "uio_slcan.h"
+
+#if UIO_SLCAN_ENABLE && UIO_CAN_COUNT
+
+#include "string.h"
+#include "clockcnt.h"
+
+TUsbFuncSlcan  usb_func_slcan;
+TUioSlcan      g_slcan;
+
+static const uint32_t slcan_speeds[9] =
+{
+  10000, 20000, 50000, 100000, 125000, 250000, 500000, 800000, 1000000
+};
+
+static const char hexchars[] = "0123456789ABCDEF";
+
+static int hexval(char c)
+{
+  if ((c >= '0') && (c <= '9'))  return c - '0';
+  if ((c >= 'A') && (c <= 'F'))  return c - 'A' + 10;
+  if ((c >= 'a') && (c <= 'f'))  return c - 'a' + 10;
+  return -1;
+}
+
+static bool parse_hex(const char * astr, unsigned adigits, uint32_t * rvalue)
+{
+  uint32_t v = 0;
+  while (adigits)
+  {
+    int d = hexval(*astr);
+    if (d < 0)
+    {
+      return false;
+    }
+    v = (v << 4) | d;
+    ++astr;
+    --adigits;
+  }
+  *rvalue = v;
+  return true;
+}
+
+static char * put_hex(char * dst, uint32_t avalue, unsigned adigits)
+{
+  while (adigits)
+  {
+    --adigits;
+    *dst++ = hexchars[(avalue >> (adigits * 4)) & 0xF];
+  }
+  return dst;
+}
+
+//-----------------------------------------------------------------------------
+// USB CDC function
+
+bool TUsbSlcanData::HandleTransferEvent(TUsbEndpoint * aep, bool htod)
+{
+  if (htod)
+  {
+    uint8_t buf[UIO_SLCAN_PACKET_SIZE];
+    int r = ep_output.ReadRecvData(&buf[0], sizeof(buf));
+    if (r > 0)
+    {
+      slcan->ProcessInput(&buf[0], r);
+    }
+    ep_output.EnableRecv();
+  }
+  else
+  {
+    slcan->TxFinished();
+  }
+
+  return true;
+}
+
+bool TUsbFuncSlcan::InitFunction()
+{
+  funcdesc.interface_class = 0x02;     // CDC
+  funcdesc.interface_subclass = 0x02;  // ACM
+  funcdesc.interface_protocol = 0x00;
+
+  func_name = "UNIVIO-SLCAN";
+  uif_control.interface_name = "SLCAN Control";
+  uif_data.interface_name = "SLCAN Data";
+
+  uif_control.dataif = &uif_data;
+  AddInterface(&uif_control);
+  AddInterface(&uif_data);
+
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+// SLCAN protocol
+
+void TUioSlcan::Init(TUioCanCtrl * acanctrl, TUsbFuncSlcan * ausbfunc)
+{
+  canctrl = acanctrl;
+  usbfunc = ausbfunc;
+  usbfunc->uif_data.slcan = this;
+
+  opened = false;
+  timestamps = false;
+  status = 0;
+  cmdlen = 0;
+  tx_wr = 0;
+  tx_rd = 0;
+  tx_busy = false;
+  ms_time = 0;
+  ms_clocks = 0;
+  ms_last_time = CLOCKCNT;
+}
+
+void TUioSlcan::Run()
+{
+  unsigned t = CLOCKCNT;
+  unsigned clocks_per_ms = SystemCoreClock / 1000;
+  ms_clocks += t - ms_last_time;
+  ms_last_time = t;
+  while (ms_clocks >= clocks_per_ms)
+  {
+    ms_clocks -= clocks_per_ms;
+    ++ms_time;
+  }
+
+  if (opened)
+  {
+    ForwardRxFrames();
+  }
+
+  FlushTx();
+}
+
+void TUioSlcan::ProcessInput(uint8_t * adata, unsigned alen)
+{
+  while (alen)
+  {
+    char c = *adata;
+    if ('\r' == c)
+    {
+      ExecCommand();
+      cmdlen = 0;
+    }
+    else if ('\n' != c)
+    {
+      if (cmdlen < UIO_SLCAN_CMD_MAXLEN)
+      {
+        cmdbuf[cmdlen] = c;
+      }
+      ++cmdlen;  // too long commands are rejected at the '\r'
+    }
+    ++adata;
+    --alen;
+  }
+}
+
+void TUioSlcan::ExecCommand()
+{
+  static const char ok_str[] = "\r";
+  static const char err_str[] = "\a";
+
+  if ((0 == cmdlen) || (cmdlen > UIO_SLCAN_CMD_MAXLEN))
+  {
+    AddResponse(err_str, 1);
+    return;
+  }
+
+  THwCan * can = canctrl->can;
+  char cmd = cmdbuf[0];
+  bool ok = false;
+
+  if ('S' == cmd)  // S0 - S8: bit rate
+  {
+    int n = hexval(cmdbuf[1]);
+    if (!opened && (2 == cmdlen) && (n >= 0) && (n <= 8))
+    {
+      can->SetSpeed(slcan_speeds[n]);
+      ok = true;
+    }
+  }
+  else if (('O' == cmd) || ('L' == cmd))  // open normal / listen only
+  {
+    if (!opened)
+    {
+      can->silent_monitor_mode = ('L' == cmd);
+      canctrl->SetActive(true);
+      rx_cnt = canctrl->mstatus.rx_cnt;  // the older messages are not forwarded
+      status = 0;
+      opened = true;
+      ok = true;
+    }
+  }
+  else if ('C' == cmd)  // close
+  {
+    if (opened)
+    {
+      canctrl->SetActive(false);
+      opened = false;
+      ok = true;
+    }
+  }
+  else if (('t' == cmd) || ('T' == cmd) || ('r' == cmd) || ('R' == cmd))
+  {
+    if (opened && !can->silent_monitor_mode && CmdSendFrame(('T' == cmd) || ('R' == cmd), ('r' == cmd) || ('R' == cmd)))
+    {
+      AddResponse((('t' == cmd) || ('r' == cmd)) ? "z\r" : "Z\r", 2);
+      return;
+    }
+  }
+  else if ('F' == cmd)  // status flags
+  {
+    uint8_t st = status;
+    if (can->IsBusOff())   st |= UIO_SLCAN_ST_BUSOFF;
+    if (can->IsWarning())  st |= UIO_SLCAN_ST_ERRWARN;
+    status = 0;
+
+    char rstr[4] = {'F', hexchars[st >> 4], hexchars[st & 0xF], '\r'};
+    AddResponse(&rstr[0], 4);
+    return;
+  }
+  else if ('V' == cmd)  // hardware and software version
+  {
+    AddResponse("V1013\r", 6);
+    return;
+  }
+  else if ('N' == cmd)  // serial number
+  {
+    AddResponse("NUIO0\r", 6);
+    return;
+  }
+  else if ('Z' == cmd)  // timestamps on / off
+  {
+    if ((2 == cmdlen) && (('0' == cmdbuf[1]) || ('1' == cmdbuf[1])))
+    {
+      timestamps = ('1' == cmdbuf[1]);
+      ok = true;
+    }
+  }
+  else if (('M' == cmd) || ('m' == cmd))  // SJA1000 acceptance code / mask: the UDO filters are used instead
+  {
+    ok = true;
+  }
+
+  AddResponse((ok ? ok_str : err_str), 1);
+}
+
+bool TUioSlcan::CmdSendFrame(bool aext, bool artr)
+{
+  unsigned idlen = (aext ? 8 : 3);
+  if (cmdlen < 2 + idlen)
+  {
+    return false;
+  }
+
+  TUioCanMsg msg;
+  uint32_t id;
+  uint32_t dlc;
+  if (!parse_hex(&cmdbuf[1], idlen, &id) || !parse_hex(&cmdbuf[1 + idlen], 1, &dlc) || (dlc > 8))
+  {
+    return false;
+  }
+
+  unsigned dlen = (artr ? 0 : dlc);
+  if (cmdlen != 2 + idlen + 2 * dlen)
+  {
+    return false;
+  }
+
+  if (aext)
+  {
+    if (id > UIO_CAN_ID_MASK_EXT)  return false;
+    msg.can_id = UIO_CAN_ID_EXT | id;
+  }
+  else
+  {
+    if (id > UIO_CAN_ID_MASK_STD)  return false;
+    msg.can_id = id;
+  }
+  if (artr)
+  {
+    msg.can_id |= UIO_CAN_ID_RTR;
+  }
+
+  msg.can_dlc = dlc;
+  msg.__pad = 0;
+  msg.timestamp = 0;
+  memset(&msg.data[0], 0, sizeof(msg.data));
+
+  const char * dp = &cmdbuf[2 + idlen];
+  for (unsigned n = 0; n < dlen; ++n)
+  {
+    uint32_t b;
+    if (!parse_hex(dp, 2, &b))
+    {
+      return false;
+    }
+    msg.data[n] = b;
+    dp += 2;
+  }
+
+  return canctrl->SendMessage(&msg);
+}
+
+void TUioSlcan::ForwardRxFrames()
+{
+  TUioCanMsg msg;
+
+  uint32_t back = canctrl->mstatus.rx_cnt - rx_cnt;
+  if (back > canctrl->rxring_size)  // the host could not keep up
+  {
+    status |= UIO_SLCAN_ST_RXOVERRUN;
+    rx_cnt = canctrl->mstatus.rx_cnt - canctrl->rxring_size;
+  }
+
+  // "T" + 8 id + dlc + 16 data + 4 timestamp + "\r" = 31 characters at most
+  while ((TxFree() >= UIO_SLCAN_TX_RESERVE) && canctrl->RxMessage(rx_cnt, &msg))
+  {
+    char   line[32];
+    char * dp = &line[0];
+    bool   rtr = (0 != (msg.can_id & UIO_CAN_ID_RTR));
+
+    if (msg.can_id & UIO_CAN_ID_EXT)
+    {
+      *dp++ = (rtr ? 'R' : 'T');
+      dp = put_hex(dp, msg.can_id & UIO_CAN_ID_MASK_EXT, 8);
+    }
+    else
+    {
+      *dp++ = (rtr ? 'r' : 't');
+      dp = put_hex(dp, msg.can_id & UIO_CAN_ID_MASK_STD, 3);
+    }
+
+    unsigned dlc = (msg.can_dlc > 8 ? 8 : msg.can_dlc);
+    *dp++ = hexchars[dlc];
+    if (!rtr)
+    {
+      for (unsigned n = 0; n < dlc; ++n)
+      {
+        dp = put_hex(dp, msg.data[n], 2);
+      }
+    }
+
+    if (timestamps)
+    {
+      dp = put_hex(dp, ms_time % 60000, 4);
+    }
+    *dp++ = '\r';
+
+    AddResponse(&line[0], dp - &line[0]);
+    ++rx_cnt;
+  }
+}
+
+unsigned TUioSlcan::TxFree()
+{
+  return UIO_SLCAN_TXRING_SIZE - 1 - ((tx_wr - tx_rd) & (UIO_SLCAN_TXRING_SIZE - 1));
+}
+
+void TUioSlcan::AddResponse(const char * astr, unsigned alen)
+{
+  if (TxFree() < alen)
+  {
+    return;  // should not happen, the received frames leave enough reserve
+  }
+
+  while (alen)
+  {
+    txring[tx_wr] = *astr;
+    tx_wr = ((tx_wr + 1) & (UIO_SLCAN_TXRING_SIZE - 1));
+    ++astr;
+    --alen;
+  }
+}
+
+void TUioSlcan::FlushTx()
+{
+  if (tx_busy || (tx_wr == tx_rd))
+  {
+    return;
+  }
+
+  // many lines are batched into one USB packet
+  unsigned len = 0;
+  while ((len < UIO_SLCAN_PACKET_SIZE) && (tx_rd != tx_wr))
+  {
+    pktbuf[len++] = txring[tx_rd];
+    tx_rd = ((tx_rd + 1) & (UIO_SLCAN_TXRING_SIZE - 1));
+  }
+
+  tx_busy = true;
+  usbfunc->uif_data.ep_input.StartSendData(&pktbuf[0], len);
+}
+
+void TUioSlcan::TxFinished()
+{
+  tx_busy = false;
+  FlushTx();
+}
+
+#endif
@@ -0,0 +1,124 @@
+/* -----------------------------------------------------------------------------
+ * This file is a part of the UNIVIO project: https://github.com/nvitya/univio
+ * Copyright (c) 2022 Viktor Nagy, nvitya
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from
+ * the use of this software. Permission is granted to anyone to use this
+ * software for any purpose, including commercial applications, and to alter
+ * it and redistribute it freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software in
+ *    a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ * --------------------------------------------------------------------------- */
+/*
+ *  file:     uio_slcan.h
+ *  brief:    SLCAN (LAWICEL) ASCII protocol on a USB CDC function for the first CAN unit
+ *  date:     2026-10-19
+ *  authors:  nvitya
+ *  notes:
+ *    on Linux: slcand -o -s6 -t hw /dev/ttyACMx can0
+*/
+
+#ifndef UIOCORE_UIO_SLCAN_H_
+#define UIOCORE_UIO_SLCAN_H_
+
+#include "uio_common.h"
+
+#if UIO_SLCAN_ENABLE && UIO_CAN_COUNT
+
+#include "usbdevice.h"
+#include "usbif_cdc.h"
+#include "uio_can_control.h"
+
+#define UIO_SLCAN_PACKET_SIZE   64   // USB FS bulk packet
+#define UIO_SLCAN_CMD_MAXLEN    32   // "T1FFFFFFF8DDDDDDDDDDDDDDDD" + timestamp
+#define UIO_SLCAN_TXRING_SIZE   512  // must be power of 2
+#define UIO_SLCAN_TX_RESERVE    256  // kept free for the command responses
+
+// status flags for the "F" command
+#define UIO_SLCAN_ST_RXOVERRUN  (1 << 3)
+#define UIO_SLCAN_ST_ERRWARN    (1 << 2)
+#define UIO_SLCAN_ST_BUSOFF     (1 << 7)
+
+class TUioSlcan;
+
+class TUsbSlcanControl : public TUsbCdcControl
+{
+};
+
+class TUsbSlcanData : public TUsbCdcData
+{
+private:
+  typedef TUsbCdcData super;
+
+public:
+  TUioSlcan *       slcan = nullptr;
+
+  virtual bool      HandleTransferEvent(TUsbEndpoint * aep, bool htod);
+};
+
+class TUsbFuncSlcan : public TUsbFunction
+{
+private:
+  typedef TUsbFunction super;
+
+public:
+  TUsbSlcanControl  uif_control;
+  TUsbSlcanData     uif_data;
+
+  virtual bool      InitFunction();
+};
+
+class TUioSlcan
+{
+public:
+  TUioCanCtrl *     canctrl = nullptr;
+  TUsbFuncSlcan *   usbfunc = nullptr;
+
+  bool              opened = false;
+  bool              timestamps = false;
+  uint8_t           status = 0;       // status flags, cleared by the "F" command
+  uint32_t          rx_cnt = 0;       // next message to forward from the CAN rx ring, independent of the UDO reader
+  uint32_t          ms_time = 0;      // millisecond time for the timestamps
+  unsigned          ms_clocks = 0;
+  unsigned          ms_last_time = 0;
+
+  char              cmdbuf[UIO_SLCAN_CMD_MAXLEN];
+  unsigned          cmdlen = 0;
+
+  // the output is collected into a ring, and sent in full USB packets when possible
+  uint8_t           txring[UIO_SLCAN_TXRING_SIZE];
+  unsigned          tx_wr = 0;
+  unsigned          tx_rd = 0;
+  uint8_t           pktbuf[UIO_SLCAN_PACKET_SIZE];
+  bool              tx_busy = false;
+
+  void              Init(TUioCanCtrl * acanctrl, TUsbFuncSlcan * ausbfunc);
+  void              Run();
+
+  void              ProcessInput(uint8_t * adata, unsigned alen);
+  void              TxFinished();
+
+protected:
+  void              ExecCommand();
+  bool              CmdSendFrame(bool aext, bool artr);
+  unsigned          TxFree();
+  void              AddResponse(const char * astr, unsigned alen);
+  void              ForwardRxFrames();
+  void              FlushTx();
+};
+
+extern TUsbFuncSlcan  usb_func_slcan;
+extern TUioSlcan      g_slcan;
+
+#endif
+
+#endif /* UIOCORE_UIO_SLCAN_H_ */
@@ -27,29 +27,121 @@
 
 #include "uio_spi_control.h"
 #include "uio_dev_base.h"
+#include "clockcnt.h"
+#include "string.h"
 
 THwSpi        g_spi[UIO_SPI_COUNT];
 TUioSpiCtrl   g_spictrl[UIO_SPI_COUNT];
 
 void TUioSpiCtrl::Init(TUioDevBase * adevbase, THwSpi * aspi)
 {
+  unsigned n;
+
   devbase = adevbase;
   spi = aspi;
+
+  for (n = 0; n < UIO_SPI_PROFILE_COUNT; ++n)
+  {
+    profile[n].speed = 1000000;
+    profile[n].mode = 0;
+    profile[n].cs_pinid = UIO_SPI_CS_DEFAULT;
+    profile[n].lsb_first = 0;
+    profile[n]._reserved = 0;
+  }
 }
 
-void TUioSpiCtrl::UpdateSettings()
+void TUioSpiCtrl::UpdateSettings(uint32_t aspeed, uint8_t amode, bool alsbfirst)
 {
-  bool ichigh = (0 != (spi_mode & (1 << 1)));
-  bool dslate = (0 != (spi_mode & (1 << 0)));
-  if ((spi->speed != spi_speed) || (ichigh != spi->idleclk_high) || (dslate != spi->datasample_late))
+  bool ichigh = (0 != (amode & (1 << 1)));
+  bool dslate = (0 != (amode & (1 << 0)));
+  if ((spi->speed != aspeed) || (ichigh != spi->idleclk_high) || (dslate != spi->datasample_late)
+      || (alsbfirst != spi->lsb_first))
   {
     spi->idleclk_high    = ichigh;
     spi->datasample_late = dslate;
-    spi->speed = spi_speed;
-    spi->Init(spi->devnum); // re-init the device
+    spi->lsb_first = alsbfirst;
+    spi->speed = aspeed;
+    if (!devbase->SpiReconfigure(spi))  // only the changed registers, when the board supports it
+    {
+      spi->Init(spi->devnum); // re-init the device
+      ++reinit_cnt;
+    }
+  }
+}
+
+void TUioSpiCtrl::ApplyActiveSettings()
+{
+  if (active_profile < UIO_SPI_PROFILE_COUNT)
+  {
+    TUioSpiProfile * pprof = &profile[active_profile];
+    UpdateSettings(pprof->speed, pprof->mode, pprof->lsb_first);
+  }
+  else
+  {
+    UpdateSettings(spi_speed, spi_mode, false);
   }
 }
 
+TGpioPin * TUioSpiCtrl::ProfileCsPin(uint8_t aprofile)
+{
+  if (!board_cspin)
+  {
+    board_cspin = spi->manualcspin;  // the first selection happens with the board CS pin
+  }
+
+  if ((aprofile >= UIO_SPI_PROFILE_COUNT) || (UIO_SPI_CS_DEFAULT == profile[aprofile].cs_pinid))
+  {
+    return board_cspin;
+  }
+
+  return &g_pins[profile[aprofile].cs_pinid];
+}
+
+bool TUioSpiCtrl::ProfileValid(uint8_t aprofile)
+{
+  TUioSpiProfile * pprof = &profile[aprofile];
+  if (0 == pprof->speed)
+  {
+    return false;
+  }
+
+  if (UIO_SPI_CS_DEFAULT != pprof->cs_pinid)
+  {
+    uint32_t pincfg = ((pprof->cs_pinid < UIO_PIN_COUNT) ? devbase->cfg.pinsetup[pprof->cs_pinid] : 0);
+    if (((pincfg & 0xFF) != UIO_PINTYPE_SPI) || !(pincfg & UIO_PINFLAG_SPI_CS))
+    {
+      return false;  // the pin is not configured as SPI CS
+    }
+  }
+
+  return true;
+}
+
+uint16_t TUioSpiCtrl::SelectProfile(uint8_t aprofile)
+{
+  if (spi_status)
+  {
+    return UDOERR_BUSY;
+  }
+
+  if ((aprofile >= UIO_SPI_PROFILE_COUNT) && (UIO_SPI_PROFILE_NONE != aprofile))
+  {
+    return UDOERR_WRITE_VALUE;
+  }
+
+  if ((aprofile < UIO_SPI_PROFILE_COUNT) && !ProfileValid(aprofile))
+  {
+    return UIOERR_UNIT_PARAMS;
+  }
+
+  // switching the CS pin does not require any SPI register change
+  spi->manualcspin = ProfileCsPin(aprofile);
+  active_profile = aprofile;
+  ApplyActiveSettings();
+
+  return 0;
+}
+
 uint16_t TUioSpiCtrl::SpiStart()
 {
   if (spi_status)
@@ -68,25 +160,355 @@ uint16_t TUioSpiCtrl::SpiStart()
     return UIOERR_UNIT_PARAMS;
   }
 
-  UpdateSettings();
+  ApplyActiveSettings();
 
   spi->StartTransfer(0, 0, 0, spi_trlen, &devbase->mpram[spi_tx_offs], &devbase->mpram[spi_rx_offs]);
 
-  spi_status = 1;
+  spi_status = UIO_SPI_ST_SINGLE;
 
   return 0;
 }
 
-void TUioSpiCtrl::Run()
+uint16_t TUioSpiCtrl::ChainStart()
 {
+  unsigned n;
+
   if (spi_status)
+  {
+    return UDOERR_BUSY;
+  }
+
+  if (!spi)
+  {
+    return UIOERR_UNITSEL;
+  }
+
+  if ((0 == chain_cnt) || (chain_cnt > UIO_SPI_CHAIN_MAX) || (chain_offs & 3)
+      || (chain_offs + chain_cnt * sizeof(TUioSpiChainDesc) > UIO_MPRAM_SIZE))
+  {
+    return UIOERR_UNIT_PARAMS;
+  }
+
+  // check all the descriptors before starting, so a chain never runs partially
+  TUioSpiChainDesc * pdesc = (TUioSpiChainDesc *)&devbase->mpram[chain_offs];
+  for (n = 0; n < chain_cnt; ++n, ++pdesc)
+  {
+    uint8_t prof = ((pdesc->flags >> UIO_SPICH_PROFILE_SHIFT) & 7);
+    if ((0 == pdesc->len) || (pdesc->delay_us > 1000000)
+        || (prof > UIO_SPI_PROFILE_COUNT) || (prof && !ProfileValid(prof - 1))
+        || (pdesc->len > UIO_MPRAM_SIZE - pdesc->tx_offs)
+        || (!(pdesc->flags & UIO_SPICH_FLAG_NORX) && (pdesc->len > UIO_MPRAM_SIZE - pdesc->rx_offs)))
+    {
+      chain_idx = n;
+      return UIOERR_UNIT_PARAMS;
+    }
+  }
+
+  // the CS is controlled here, because it might be held between the transfers
+  ProfileCsPin(active_profile);  // capture the board CS pin
+  chain_saved_cspin = spi->manualcspin;
+  chain_cspin = chain_saved_cspin;
+  spi->manualcspin = nullptr;
+
+  chain_idx = 0;
+  chain_state = 0;
+  spi_status = UIO_SPI_ST_CHAIN;
+
+  RunChain();
+
+  return 0;
+}
+
+void TUioSpiCtrl::RunChain()
+{
+  TUioSpiChainDesc * pdesc = ((TUioSpiChainDesc *)&devbase->mpram[chain_offs]) + chain_idx;
+
+  while (true)
+  {
+    if (0 == chain_state)  // start the next transfer
+    {
+      if (chain_idx >= chain_cnt)
+      {
+        if (chain_cspin)  chain_cspin->Set1();
+        spi->manualcspin = chain_saved_cspin;
+        ApplyActiveSettings();  // for the following single transfers
+        spi_status = UIO_SPI_ST_IDLE;
+        return;
+      }
+
+      uint8_t prof = ((pdesc->flags >> UIO_SPICH_PROFILE_SHIFT) & 7);
+      TGpioPin * cspin = chain_saved_cspin;
+      if (prof)
+      {
+        TUioSpiProfile * pprof = &profile[prof - 1];
+        UpdateSettings(pprof->speed, pprof->mode, pprof->lsb_first);
+        cspin = ProfileCsPin(prof - 1);
+      }
+      else
+      {
+        UpdateSettings((pdesc->speed ? pdesc->speed : spi_speed), pdesc->mode, false);
+      }
+
+      if (cspin != chain_cspin)  // other device, release the held CS
+      {
+        if (chain_cspin)  chain_cspin->Set1();
+        chain_cspin = cspin;
+      }
+
+      if (chain_cspin)  chain_cspin->Set0();
+      spi->StartTransfer(0, 0, 0, pdesc->len, &devbase->mpram[pdesc->tx_offs],
+                         (pdesc->flags & UIO_SPICH_FLAG_NORX ? nullptr : &devbase->mpram[pdesc->rx_offs]));
+      chain_state = 1;
+    }
+
+    if (1 == chain_state)  // transfer running
+    {
+      spi->Run();
+      if (!spi->finished)
+      {
+        return;
+      }
+
+      if (chain_cspin && !(pdesc->flags & UIO_SPICH_FLAG_CSHOLD))
+      {
+        chain_cspin->Set1();
+      }
+
+      chain_delay_clocks = pdesc->delay_us * (SystemCoreClock / 1000000);
+      chain_delay_start = CLOCKCNT;
+      chain_state = 2;
+    }
+
+    if (2 == chain_state)  // inter-transfer delay
+    {
+      if (CLOCKCNT - chain_delay_start < chain_delay_clocks)
+      {
+        return;
+      }
+
+      ++chain_idx;
+      ++pdesc;
+      chain_state = 0;
+    }
+  }
+}
+
+// WS2812 LED stripe: every data bit is sent as 3 SPI bits (1 = 110, 0 = 100) at 2.4 MHz.
+// The encoding of one nibble into 12 SPI bits:
+static const uint16_t ws2812_nibble_code[16] =
+{
+  0x924, 0x926, 0x934, 0x936, 0x9A4, 0x9A6, 0x9B4, 0x9B6,
+  0xD24, 0xD26, 0xD34, 0xD36, 0xDA4, 0xDA6, 0xDB4, 0xDB6
+};
+
+void TUioSpiCtrl::LedStripeEncode(uint8_t * adst)
+{
+  unsigned n, c;
+  uint8_t  grbw[4];
+  unsigned colors = (led_format ? 4 : 3);
+  uint8_t * psrc = &devbase->mpram[led_src_offs];
+  uint8_t * pdst = adst;
+
+  memset(pdst, 0, led_reset_bytes);
+  pdst += led_reset_bytes;
+
+  for (n = 0; n < led_count; ++n)
+  {
+    // RGB(W) -> GRB(W)
+    grbw[0] = psrc[1];
+    grbw[1] = psrc[0];
+    grbw[2] = psrc[2];
+    grbw[3] = (led_format ? psrc[3] : 0);
+    psrc += colors;
+
+    for (c = 0; c < colors; ++c)
+    {
+      uint32_t code = ((ws2812_nibble_code[grbw[c] >> 4] << 12) | ws2812_nibble_code[grbw[c] & 0xF]);
+      pdst[0] = (code >> 16);
+      pdst[1] = (code >>  8);
+      pdst[2] = (code >>  0);
+      pdst += 3;
+    }
+  }
+
+  memset(pdst, 0, led_reset_bytes);  // the reset gap
+}
+
+uint16_t TUioSpiCtrl::LedStripeStart()
+{
+  if (!spi)
+  {
+    return UIOERR_UNITSEL;
+  }
+
+  // a new frame can be prepared while the previous one is shifted out
+  if ((spi_status && (UIO_SPI_ST_LEDSTRIPE != spi_status)) || led_pending)
+  {
+    return UDOERR_BUSY;
+  }
+
+  unsigned colors = (led_format ? 4 : 3);
+  uint32_t framelen = 2 * led_reset_bytes + 3 * colors * led_count;
+  if ((0 == led_count) || (led_format > 1) || (0 == spi_speed)
+      || (led_src_offs + colors * led_count > UIO_MPRAM_SIZE)
+      || (led_enc_offs + 2 * framelen > UIO_MPRAM_SIZE))
+  {
+    return UIOERR_UNIT_PARAMS;
+  }
+
+  if ((UIO_SPI_ST_LEDSTRIPE == spi_status) && (framelen != led_frame_len))
+  {
+    return UDOERR_BUSY;  // the frame length can not be changed while the other buffer is sent
+  }
+
+  led_frame_len = framelen;
+
+  if (UIO_SPI_ST_LEDSTRIPE == spi_status)
+  {
+    LedStripeEncode(&devbase->mpram[led_enc_offs + (led_bufidx ^ 1) * framelen]);
+    led_pending = true;
+    return 0;
+  }
+
+  led_bufidx ^= 1;
+  LedStripeEncode(&devbase->mpram[led_enc_offs + led_bufidx * framelen]);
+
+  ApplyActiveSettings();
+  spi->StartTransfer(0, 0, 0, framelen, &devbase->mpram[led_enc_offs + led_bufidx * framelen], nullptr);
+  spi_status = UIO_SPI_ST_LEDSTRIPE;
+
+  return 0;
+}
+
+uint16_t TUioSpiCtrl::StreamStart()
+{
+  if (spi_status)
+  {
+    return UDOERR_BUSY;
+  }
+
+  if (!spi)
+  {
+    return UIOERR_UNITSEL;
+  }
+
+  if ((0 == spi_speed) || (0 == spi_trlen) || (spi_trlen > UIO_MPRAM_SIZE - spi_tx_offs)
+      || (0 == strm_ring_frames) || (strm_ring_offs + strm_ring_frames * spi_trlen > UIO_MPRAM_SIZE)
+      || (strm_period_us < UIO_SPI_STRM_PERIOD_MIN) || (strm_period_us > 10000000))
+  {
+    return UIOERR_UNIT_PARAMS;
+  }
+
+  ApplyActiveSettings();
+
+  strm_prod_cnt = 0;
+  strm_cons_cnt = 0;
+  strm_overflows = 0;
+  strm_late_cnt = 0;
+  strm_rxptr = nullptr;
+  strm_busy = false;
+  strm_stop = false;
+  strm_period_clocks = strm_period_us * (SystemCoreClock / 1000000);
+  strm_next_time = CLOCKCNT;
+
+  spi_status = UIO_SPI_ST_STREAM;
+
+  RunStream();
+
+  return 0;
+}
+
+void TUioSpiCtrl::RunStream()
+{
+  // The frames are paced by the CLOCKCNT from the main loop, so the start
+  // jitter depends on the main loop cycle time, but the periods do not drift.
+
+  if (strm_busy)
+  {
+    spi->Run();
+    if (!spi->finished)
+    {
+      return;
+    }
+
+    strm_busy = false;
+    if (strm_rxptr)
+    {
+      ++strm_prod_cnt;  // the frame is stored
+      strm_rxptr = nullptr;
+    }
+  }
+
+  if (strm_stop)
+  {
+    strm_stop = false;
+    spi_status = UIO_SPI_ST_IDLE;
+    return;
+  }
+
+  unsigned t = CLOCKCNT;
+  if (int(t - strm_next_time) < 0)
+  {
+    return;
+  }
+
+  if (t - strm_next_time >= strm_period_clocks)  // one or more periods were missed
+  {
+    strm_late_cnt += (t - strm_next_time) / strm_period_clocks;
+    strm_next_time = t;
+  }
+  strm_next_time += strm_period_clocks;
+
+  uint8_t * rxptr = nullptr;
+  if (strm_prod_cnt - strm_cons_cnt < strm_ring_frames)
+  {
+    rxptr = &devbase->mpram[strm_ring_offs + (strm_prod_cnt % strm_ring_frames) * spi_trlen];
+  }
+  else
+  {
+    ++strm_overflows;  // the host did not read the ring fast enough, the frame is still clocked
+  }
+
+  strm_rxptr = rxptr;
+  strm_busy = true;
+  spi->StartTransfer(0, 0, 0, spi_trlen, &devbase->mpram[spi_tx_offs], rxptr);
+}
+
+void TUioSpiCtrl::Run()
+{
+  if (UIO_SPI_ST_CHAIN == spi_status)
+  {
+    RunChain();
+  }
+  else if (UIO_SPI_ST_STREAM == spi_status)
+  {
+    RunStream();
+  }
+  else if (UIO_SPI_ST_LEDSTRIPE == spi_status)
   {
     spi->Run();
     if (spi->finished)
     {
-    	if (1 == spi_status)  // the SPI Flash accelerator also controls the SPI with spi_status=8
+      if (led_pending)  // send the next frame
+      {
+        led_pending = false;
+        led_bufidx ^= 1;
+        spi->StartTransfer(0, 0, 0, led_frame_len, &devbase->mpram[led_enc_offs + led_bufidx * led_frame_len], nullptr);
+      }
+      else
+      {
+        spi_status = UIO_SPI_ST_IDLE;
+      }
+    }
+  }
+  else if (spi_status)
+  {
+    spi->Run();
+    if (spi->finished)
+    {
+    	if (UIO_SPI_ST_SINGLE == spi_status)  // the SPI Flash accelerator also controls the SPI with spi_status=8
     	{
-    		spi_status = 0;
+    		spi_status = UIO_SPI_ST_IDLE;
     	}
     }
   }
@@ -117,12 +539,41 @@ bool TUioSpiCtrl::prfn_SpiControl(TUdoRequest * rq, TParamRangeDef * prdef)
     if (rq->iswrite)
     {
       uint32_t rv32 = udorq_uintvalue(rq);
-      if (1 == rv32)
+      if (0 == rv32)
+      {
+        // stop the streaming, the status goes idle when the running frame is finished
+        if (UIO_SPI_ST_STREAM != spi_status)
+        {
+          return udo_response_error(rq, UDOERR_WRITE_VALUE);
+        }
+
+        strm_stop = true;
+        return udo_response_ok(rq);
+      }
+      else if (1 == rv32)
       {
         // start the SPI transaction
         uint16_t err = SpiStart();
         return udo_response_error(rq, err); // will be response ok with err=0
       }
+      else if (2 == rv32)
+      {
+        // start the descriptor chain
+        uint16_t err = ChainStart();
+        return udo_response_error(rq, err);
+      }
+      else if (3 == rv32)
+      {
+        // encode and send a LED stripe frame
+        uint16_t err = LedStripeStart();
+        return udo_response_error(rq, err);
+      }
+      else if (4 == rv32)
+      {
+        // start the continuous streaming
+        uint16_t err = StreamStart();
+        return udo_response_error(rq, err);
+      }
       else
       {
         return udo_response_error(rq, UDOERR_WRITE_VALUE);
@@ -141,6 +592,101 @@ bool TUioSpiCtrl::prfn_SpiControl(TUdoRequest * rq, TParamRangeDef * prdef)
   {
     return udo_rw_data(rq, &spi_rx_offs, sizeof(spi_rx_offs));
   }
+  else if (0x06 == idx) // SPI chain descriptor list MPRAM offset
+  {
+    return udo_rw_data(rq, &chain_offs, sizeof(chain_offs));
+  }
+  else if (0x07 == idx) // SPI chain descriptor count
+  {
+    return udo_rw_data(rq, &chain_cnt, sizeof(chain_cnt));
+  }
+  else if (0x08 == idx) // SPI chain executed descriptors, or the index of the invalid one
+  {
+    return udo_ro_uint(rq, chain_idx, 2);
+  }
+  else if (0x18 == idx) // active SPI profile, 0xFF = none (0x00 settings with the board CS)
+  {
+    if (rq->iswrite)
+    {
+      uint16_t err = SelectProfile(udorq_uintvalue(rq));
+      return udo_response_error(rq, err);
+    }
+    return udo_ro_uint(rq, active_profile, 1);
+  }
+  else if ((0x19 <= idx) && (idx < 0x19 + UIO_SPI_PROFILE_COUNT)) // SPI profiles: speed, mode, CS pin, LSB first
+  {
+    uint8_t pidx = idx - 0x19;
+    if (rq->iswrite && (pidx == active_profile))
+    {
+      if (spi_status)
+      {
+        return udo_response_error(rq, UDOERR_BUSY);
+      }
+      SelectProfile(UIO_SPI_PROFILE_NONE);  // the changed profile must be selected again
+    }
+    return udo_rw_data(rq, &profile[pidx], sizeof(profile[0]));
+  }
+  else if (0x1D == idx) // SPI peripheral re-init count
+  {
+    return udo_ro_uint(rq, reinit_cnt, 4);
+  }
+  else if (0x0A == idx) // LED stripe: packed RGB(W) data MPRAM offset
+  {
+    return udo_rw_data(rq, &led_src_offs, sizeof(led_src_offs));
+  }
+  else if (0x0B == idx) // LED stripe: LED count
+  {
+    return udo_rw_data(rq, &led_count, sizeof(led_count));
+  }
+  else if (0x0C == idx) // LED stripe: format, reset bytes, encoded buffer MPRAM offset
+  {
+    if (1 == rq->offset)
+    {
+      rq->offset = 0;
+      return udo_rw_data(rq, &led_reset_bytes, sizeof(led_reset_bytes));
+    }
+    else if (2 == rq->offset)
+    {
+      rq->offset = 0;
+      return udo_rw_data(rq, &led_enc_offs, sizeof(led_enc_offs));
+    }
+    return udo_rw_data(rq, &led_format, sizeof(led_format));
+  }
+  else if (0x10 == idx) // streaming: rx ring MPRAM offset
+  {
+    return udo_rw_data(rq, &strm_ring_offs, sizeof(strm_ring_offs));
+  }
+  else if (0x11 == idx) // streaming: rx ring size in frames
+  {
+    return udo_rw_data(rq, &strm_ring_frames, sizeof(strm_ring_frames));
+  }
+  else if (0x12 == idx) // streaming: frame period in us
+  {
+    return udo_rw_data(rq, &strm_period_us, sizeof(strm_period_us));
+  }
+  else if (0x13 == idx) // streaming: producer index (stored frames)
+  {
+    return udo_ro_uint(rq, strm_prod_cnt, 4);
+  }
+  else if (0x14 == idx) // streaming: consumer index, the host writes it after reading the frames
+  {
+    if (rq->iswrite)
+    {
+      uint32_t rv32 = udorq_uintvalue(rq);
+      if (rv32 - strm_cons_cnt > strm_prod_cnt - strm_cons_cnt)
+      {
+        return udo_response_error(rq, UDOERR_WRITE_VALUE);  // must be between the actual and the producer index
+      }
+      strm_cons_cnt = rv32;
+      return udo_response_ok(rq);
+    }
+    return udo_ro_uint(rq, strm_cons_cnt, 4);
+  }
+  else if (0x15 == idx) // streaming: overrun counters: ring overflows, missed periods
+  {
+    uint32_t cnts[2] = { strm_overflows, strm_late_cnt };
+    return udo_ro_data(rq, &cnts[0], sizeof(cnts));
+  }
 
   return udo_response_error(rq, UDOERR_INDEX);
 }
@@ -38,6 +38,48 @@
 
 #include "uio_common.h"
 
+// spi_status values, the spi_status is non-zero while the SPI is used
+#define UIO_SPI_ST_IDLE       0
+#define UIO_SPI_ST_SINGLE     1  // single transfer
+#define UIO_SPI_ST_CHAIN      2  // descriptor chain
+#define UIO_SPI_ST_LEDSTRIPE  3  // WS2812 LED stripe frame
+#define UIO_SPI_ST_STREAM     4  // continuous periodic frames
+#define UIO_SPI_ST_FLASH      8  // used by the SPI Flash accelerator
+
+#define UIO_SPI_CHAIN_MAX     256
+
+#define UIO_SPI_STRM_PERIOD_MIN  500  // us, the stream frames are started from the main loop, it can not keep shorter periods
+
+#define UIO_SPICH_FLAG_CSHOLD   (1 << 0)  // keep the CS active after the transfer
+#define UIO_SPICH_FLAG_NORX     (1 << 1)  // do not store the received data
+#define UIO_SPICH_PROFILE_SHIFT 4         // bits 4-6: 0 = own speed / mode, 1-4: SPI profile 0-3
+
+#define UIO_SPI_PROFILE_COUNT   4
+#define UIO_SPI_PROFILE_NONE    0xFF      // spi_speed / spi_mode with the board CS pin
+#define UIO_SPI_CS_DEFAULT      0xFF      // cs_pinid: the board CS pin
+
+typedef struct  // SPI device profile
+{
+  uint32_t          speed;
+  uint8_t           mode;      // same as spi_mode
+  uint8_t           cs_pinid;  // pin configured as SPI CS (UIO_PINFLAG_SPI_CS), 0xFF = board CS pin
+  uint8_t           lsb_first;
+  uint8_t           _reserved;
+//
+} TUioSpiProfile;  // 8 bytes
+
+typedef struct  // SPI chain descriptor in the MPRAM
+{
+  uint16_t          tx_offs;
+  uint16_t          rx_offs;
+  uint16_t          len;
+  uint8_t           mode;      // same as spi_mode
+  uint8_t           flags;     // UIO_SPICH_FLAG_*
+  uint32_t          speed;     // 0 = use the spi_speed
+  uint32_t          delay_us;  // delay after the transfer
+//
+} TUioSpiChainDesc;  // 16 bytes
+
 class TUioDevBase;
 
 class TUioSpiCtrl : public TClass
@@ -52,10 +94,62 @@ public:
   uint8_t           spi_status = 0;
   uint8_t           spi_mode = 0;
 
+  // descriptor chain
+  uint16_t          chain_offs = 0;
+  uint16_t          chain_cnt = 0;
+  uint16_t          chain_idx = 0;    // executed descriptors
+  uint8_t           chain_state = 0;
+  TGpioPin *        chain_cspin = nullptr;
+  TGpioPin *        chain_saved_cspin = nullptr;
+  unsigned          chain_delay_start = 0;
+  unsigned          chain_delay_clocks = 0;
+
+  // device profiles
+  TUioSpiProfile    profile[UIO_SPI_PROFILE_COUNT];
+  uint8_t           active_profile = UIO_SPI_PROFILE_NONE;
+  TGpioPin *        board_cspin = nullptr;
+  uint32_t          reinit_cnt = 0;
+
+  // WS2812 LED stripe
+  uint16_t          led_src_offs = 0;       // packed RGB or RGBW data
+  uint16_t          led_enc_offs = 0x1000;  // two SPI frame buffers for the encoded data
+  uint16_t          led_count = 0;
+  uint8_t           led_format = 0;         // 0 = RGB, 1 = RGBW
+  uint8_t           led_reset_bytes = 15;   // zero bytes before and after the LED data
+  uint8_t           led_bufidx = 0;         // the frame buffer which is shifted out
+  bool              led_pending = false;    // the other frame buffer is ready to send
+  uint16_t          led_frame_len = 0;
+
+  // streaming: the spi_tx_offs / spi_trlen frame is repeated periodically,
+  // the received frames are stored into the MPRAM ring
+  uint16_t          strm_ring_offs = 0;
+  uint16_t          strm_ring_frames = 0;
+  uint32_t          strm_period_us = 1000;
+  uint32_t          strm_prod_cnt = 0;     // stored frames
+  uint32_t          strm_cons_cnt = 0;     // processed frames, written by the host
+  uint32_t          strm_overflows = 0;    // frames dropped because the ring was full
+  uint32_t          strm_late_cnt = 0;     // missed frame periods
+  unsigned          strm_period_clocks = 0;
+  unsigned          strm_next_time = 0;
+  uint8_t *         strm_rxptr = nullptr;  // target of the running frame, nullptr = dropped
+  bool              strm_busy = false;     // frame transfer is running
+  bool              strm_stop = false;     // stop requested, the Run() finishes the running frame first
+
   void              Init(TUioDevBase * adevbase, THwSpi * aspi);
   void              Run();
   uint16_t          SpiStart();
-  void              UpdateSettings();
+  uint16_t          ChainStart();
+  void              RunChain();
+  uint16_t          LedStripeStart();
+  void              LedStripeEncode(uint8_t * adst);
+  uint16_t          StreamStart();
+  void              RunStream();
+  void              UpdateSettings(uint32_t aspeed, uint8_t amode, bool alsbfirst);
+  void              ApplyActiveSettings();
+  TGpioPin *        ProfileCsPin(uint8_t aprofile);
+  bool              ProfileValid(uint8_t aprofile);
+  uint16_t          SelectProfile(uint8_t aprofile);
+  bool              UserActive() { return (spi_status && (UIO_SPI_ST_FLASH != spi_status)); }
   bool              prfn_SpiControl(TUdoRequest * rq, TParamRangeDef * prdef);
 };
 
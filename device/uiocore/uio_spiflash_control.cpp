@@ -33,6 +33,7 @@
 #include "uio_dev_base.h"
 #include "board_pins.h"
 #include "spiflash.h"
+#include "string.h"
 
 TSpiFlash         extflash;
 TUioSpiFlashCtrl  g_spiflash_ctrl;
@@ -58,6 +59,7 @@ void TUioSpiFlashCtrl::Init(TUioDevBase * adevbase)
   {
     flwslot[pcnt].busy = 0;
     flwslot[pcnt].slotidx = pcnt;
+    memset(&flwresult[pcnt], 0, sizeof(TUioFlwResult));
   }
   flws_first = nullptr;
   flws_last  = nullptr;
@@ -71,7 +73,7 @@ void TUioSpiFlashCtrl::Run()
     return;
   }
 
-  if (1 == spictrl->spi_status)  // is the SPI used by the normal interface ?
+  if (spictrl->UserActive())  // is the SPI used by the normal interface ?
   {
   	return;
   }
@@ -107,6 +109,20 @@ void TUioSpiFlashCtrl::Run()
   #endif
 
   pslot = flws_first;
+  if (!pslot && sum_active)  // the queued writes go first
+  {
+    spictrl->spi_status = 8;
+    RunChecksum();
+    return;
+  }
+
+  if (!pslot && rd_active)
+  {
+    spictrl->spi_status = 8;
+    RunStreamRead();
+    return;
+  }
+
   if (!pslot)
   {
     spifl_state = 0;
@@ -123,6 +139,7 @@ void TUioSpiFlashCtrl::Run()
   {
     spifl_srcbuf = &devbase->mpram[pslot->slotidx * 4096];
     spifl_wrkbuf = &devbase->mpram[UIO_MPRAM_SIZE - 4096];
+    spifl_srccrc = uio_crc32(0, spifl_srcbuf, 4096);
 
     if (3 == pslot->cmd)
     {
@@ -159,7 +176,8 @@ void TUioSpiFlashCtrl::Run()
     if (match)
     {
       // nothing to do
-      SpiFlashSlotFinish();
+      flwresult[pslot->slotidx].crc = spifl_srccrc;
+      SpiFlashSlotFinish(UIO_FLW_RES_UNCHANGED);
       return;
     }
 
@@ -180,16 +198,74 @@ void TUioSpiFlashCtrl::Run()
     extflash.StartWriteMem(pslot->fladdr, spifl_srcbuf, 4096);
     spifl_state = 13;
   }
-  else if (13 == spifl_state) // write finished.
+  else if (13 == spifl_state) // write finished, read back for the verify
+  {
+    extflash.StartReadMem(pslot->fladdr, spifl_wrkbuf, 4096);
+    spifl_state = 14;
+  }
+  else if (14 == spifl_state) // verify read finished
   {
-    SpiFlashSlotFinish();
+    // the host uploads the next slots meanwhile, so it does not have to read back the image
+    uint32_t crc = uio_crc32(0, spifl_wrkbuf, 4096);
+    flwresult[pslot->slotidx].crc = crc;
+    SpiFlashSlotFinish(crc == spifl_srccrc ? UIO_FLW_RES_WRITTEN : UIO_FLW_RES_VERIFYERR);
   }
   else // unhandled state
   {
-    SpiFlashSlotFinish();
+    SpiFlashSlotFinish(UIO_FLW_RES_VERIFYERR);
   }
 }
 
+void TUioSpiFlashCtrl::RunChecksum()
+{
+  uint8_t * wrkbuf = &devbase->mpram[UIO_MPRAM_SIZE - 4096];
+
+  if (sum_reading)  // the sector read is finished
+  {
+    sum_crc[sum_done] = uio_crc32(0, wrkbuf, 4096);
+    ++sum_done;
+    sum_reading = false;
+  }
+
+  if (sum_done >= sum_count)
+  {
+    sum_active = false;
+    return;
+  }
+
+  extflash.StartReadMem(sum_addr + sum_done * 4096, wrkbuf, 4096);
+  sum_reading = true;
+}
+
+void TUioSpiFlashCtrl::RunStreamRead()
+{
+  if (rd_reading)  // sector read finished
+  {
+    ++rd_filled;
+    rd_reading = false;
+  }
+
+  if (rd_acked >= rd_total)
+  {
+    StreamReadStop();
+    return;
+  }
+
+  // fill the next buffer when the host has already consumed it
+  if ((rd_filled < rd_total) && (rd_filled < rd_acked + 2))
+  {
+    extflash.StartReadMem(rd_addr + rd_filled * 4096, &devbase->mpram[(rd_filled & 1) * 4096], 4096);
+    rd_reading = true;
+  }
+}
+
+void TUioSpiFlashCtrl::StreamReadStop()
+{
+  rd_active = false;
+  flwslot[0].busy = 0;
+  flwslot[1].busy = 0;
+}
+
 bool TUioSpiFlashCtrl::SpiFlashCmdPrepare()
 {
   uint8_t cmd = (spifl_cmd[0] & 0xFF);
@@ -208,7 +284,7 @@ bool TUioSpiFlashCtrl::SpiFlashCmdPrepare()
   }
   else if ((2 == cmd) || (3 == cmd))
   {
-    uint8_t sidx = ((spifl_cmd[0] >> 16) & 0x7);
+    uint8_t sidx = ((spifl_cmd[0] >> 16) & 0xF);
     if (sidx >= flws_cnt)
     {
       return false;
@@ -226,6 +302,12 @@ bool TUioSpiFlashCtrl::SpiFlashCmdPrepare()
     pslot->fladdr = spifl_cmd[1];
     pslot->next = nullptr;
 
+    TUioFlwResult * pres = &flwresult[sidx];
+    pres->fladdr = pslot->fladdr;
+    pres->crc = 0;
+    pres->result = UIO_FLW_RES_PENDING;
+    pres->cmd = cmd;
+
     // add to queue
     if (flws_last)
     {
@@ -238,6 +320,51 @@ bool TUioSpiFlashCtrl::SpiFlashCmdPrepare()
       flws_first = pslot;
     }
   }
+  else if (4 == cmd)  // CRC32 of the 4k sectors, sector count in bits 16-31
+  {
+    uint32_t cnt = (spifl_cmd[0] >> 16);
+    if (sum_active || (0 == cnt) || (cnt > UIO_FLW_SUM_MAX) || (spifl_cmd[1] & 0xFFF))
+    {
+      return false;
+    }
+
+    sum_addr = spifl_cmd[1];
+    sum_count = cnt;
+    sum_done = 0;
+    sum_reading = false;
+    sum_active = true;
+  }
+  else if (5 == cmd)  // streaming read, sector count in bits 16-31, 0 = stop
+  {
+    uint32_t cnt = (spifl_cmd[0] >> 16);
+    if (0 == cnt)
+    {
+      if (rd_active && !rd_reading)
+      {
+        StreamReadStop();
+      }
+      else if (rd_active)
+      {
+        rd_total = rd_filled + 1;  // stops after the running read
+        rd_acked = rd_total;
+      }
+      return true;
+    }
+
+    if (rd_active || (flws_cnt < 2) || flwslot[0].busy || flwslot[1].busy || (spifl_cmd[1] & 0xFFF))
+    {
+      return false;
+    }
+
+    flwslot[0].busy = 1;  // reserve the double buffer
+    flwslot[1].busy = 1;
+    rd_addr = spifl_cmd[1];
+    rd_total = cnt;
+    rd_filled = 0;
+    rd_acked = 0;
+    rd_reading = false;
+    rd_active = true;
+  }
   else
   {
     return false;
@@ -247,7 +374,7 @@ bool TUioSpiFlashCtrl::SpiFlashCmdPrepare()
   return true;
 }
 
-void TUioSpiFlashCtrl::SpiFlashSlotFinish()
+void TUioSpiFlashCtrl::SpiFlashSlotFinish(uint8_t aresult)
 {
   spifl_state = 0;
 
@@ -257,6 +384,8 @@ void TUioSpiFlashCtrl::SpiFlashSlotFinish()
     return;
   }
 
+  flwresult[pslot->slotidx].result = aresult;
+
   pslot->busy = 0;
   flws_first = pslot->next;
   if (!flws_first)
@@ -269,9 +398,9 @@ bool TUioSpiFlashCtrl::prfn_SpiFlashControl(TUdoRequest * rq, TParamRangeDef * p
 {
   uint8_t idx  = (rq->index & 0x0F);
 
-  if (0x0 == idx)  // free slot count
+  if (0x0 == idx)  // free slot bitmap
   {
-    uint8_t fsc = 0;
+    uint16_t fsc = 0;
     for (unsigned n = 0; n < flws_cnt; ++n)
     {
       if (!flwslot[n].busy)
@@ -279,7 +408,7 @@ bool TUioSpiFlashCtrl::prfn_SpiFlashControl(TUdoRequest * rq, TParamRangeDef * p
         fsc |= (1 << n);
       }
     }
-    return udo_ro_uint(rq, fsc, 1);
+    return udo_ro_uint(rq, fsc, 2);
   }
   else if (0x1 == idx)  // flash command
   {
@@ -299,7 +428,7 @@ bool TUioSpiFlashCtrl::prfn_SpiFlashControl(TUdoRequest * rq, TParamRangeDef * p
         spictrl = &g_spictrl[0];
       }
 
-      if (1 == spictrl->spi_status) // normal SPI is runing ?
+      if (spictrl->UserActive()) // normal SPI is runing ?
       {
         return udo_response_error(rq, UDOERR_BUSY);
       }
@@ -320,6 +449,46 @@ bool TUioSpiFlashCtrl::prfn_SpiFlashControl(TUdoRequest * rq, TParamRangeDef * p
   {
     return udo_ro_data(rq, &extflash.idcode, 4);
   }
+  else if (0x4 == idx)  // slot results: TUioFlwResult[slot count]
+  {
+    return udo_ro_data(rq, &flwresult[0], flws_cnt * sizeof(TUioFlwResult));
+  }
+  else if (0x5 == idx)  // slot count
+  {
+    return udo_ro_uint(rq, flws_cnt, 1);
+  }
+  else if (0x6 == idx)  // checksum command status: u16 done sectors, u16 sector count, u32 start address
+  {
+    uint32_t st[2] = {(uint32_t(sum_count) << 16) | sum_done, sum_addr};
+    return udo_ro_data(rq, &st[0], sizeof(st));
+  }
+  else if (0x7 == idx)  // sector CRC32 list of the checksum command (only when finished)
+  {
+    if (sum_active)
+    {
+      return udo_response_error(rq, UDOERR_BUSY);
+    }
+    return udo_ro_data(rq, &sum_crc[0], sum_done * 4);
+  }
+  else if (0x8 == idx)  // streaming read status: u32 start address, u32 total, u32 filled, u32 acked
+  {
+    uint32_t st[4] = {rd_addr, rd_total, rd_filled, rd_acked};
+    return udo_ro_data(rq, &st[0], sizeof(st));
+  }
+  else if (0x9 == idx)  // streaming read ack: the count of consumed sectors
+  {
+    if (rq->iswrite)
+    {
+      uint32_t v = udorq_uintvalue(rq);
+      if (!rd_active || (v > rd_filled) || (v < rd_acked))
+      {
+        return udo_response_error(rq, UDOERR_WRITE_VALUE);
+      }
+      rd_acked = v;
+      return udo_response_ok(rq);
+    }
+    return udo_ro_uint(rq, rd_acked, 4);
+  }
 
   return udo_response_error(rq, UDOERR_INDEX);
 }
@@ -41,9 +41,19 @@
 #include "hwspi.h"
 #include "hwdma.h"
 
-#define UIO_FLW_SLOT_MAX      4
+#define UIO_FLW_SLOT_MAX      15   // limited by the MPRAM size, the last sector is the work buffer
 #define UIO_FLW_SECTOR_SIZE   4096
 
+#ifndef UIO_FLW_SUM_MAX
+  #define UIO_FLW_SUM_MAX     256  // sectors per checksum command, the result fits into one response
+#endif
+
+// slot results
+#define UIO_FLW_RES_PENDING   0
+#define UIO_FLW_RES_WRITTEN   1   // written and verified
+#define UIO_FLW_RES_UNCHANGED 2   // the flash content was already the same
+#define UIO_FLW_RES_VERIFYERR 3   // the read back content differs
+
 class TUioDevBase;
 
 typedef struct TUioFlwSlot
@@ -57,6 +67,16 @@ typedef struct TUioFlwSlot
 //
 } TUioFlwSlot;
 
+typedef struct
+{
+  uint32_t          fladdr;
+  uint32_t          crc;          // CRC32 of the sector read back from the flash
+  uint8_t           result;       // UIO_FLW_RES_*
+  uint8_t           cmd;
+  uint16_t          _reserved;
+//
+} TUioFlwResult; // 12 bytes
+
 class TUioSpiFlashCtrl : public TClass
 {
 public:
@@ -67,6 +87,24 @@ public:
   TUioFlwSlot       flwslot[UIO_FLW_SLOT_MAX];
   TUioFlwSlot *     flws_first = nullptr;
   TUioFlwSlot *     flws_last  = nullptr;
+  TUioFlwResult     flwresult[UIO_FLW_SLOT_MAX];
+  uint32_t          spifl_srccrc = 0;
+
+  // sector checksum command
+  bool              sum_active = false;
+  bool              sum_reading = false;
+  uint16_t          sum_count = 0;
+  uint16_t          sum_done = 0;
+  uint32_t          sum_addr = 0;
+  uint32_t          sum_crc[UIO_FLW_SUM_MAX];
+
+  // streaming read into the MPRAM slots 0 and 1, sector k goes to slot (k & 1)
+  bool              rd_active = false;
+  bool              rd_reading = false;
+  uint32_t          rd_addr = 0;
+  uint32_t          rd_total = 0;   // sectors to read
+  uint32_t          rd_filled = 0;  // sectors read into the MPRAM
+  uint32_t          rd_acked = 0;   // sectors consumed by the host
 
   uint8_t           spifl_state = 0;
   uint32_t          spifl_cmd[2] = {0, 0};
@@ -80,7 +118,10 @@ public:
   bool              prfn_SpiFlashControl(TUdoRequest * rq, TParamRangeDef * prdef);
 
   bool              SpiFlashCmdPrepare();
-  void              SpiFlashSlotFinish();
+  void              SpiFlashSlotFinish(uint8_t aresult);
+  void              RunChecksum();
+  void              RunStreamRead();
+  void              StreamReadStop();
 };
 
 extern TUioSpiFlashCtrl  g_spiflash_ctrl;
@@ -29,6 +29,7 @@
 #include "udo_usb_comm.h"
 #include "usb_application.h"
 #include "uio_device.h"
+#include "uio_slcan.h"
 #include "traces.h"
 
 TUsbFuncUdo      usb_func_udo;
@@ -93,6 +94,11 @@ bool TUsbApplication::InitDevice()
 	  AddFunction(&usb_func_uart[n]);
 	}
 
+  #if UIO_SLCAN_ENABLE && UIO_CAN_COUNT
+    g_slcan.Init(&g_canctrl[0], &usb_func_slcan);
+    AddFunction(&usb_func_slcan);
+  #endif
+
   return true;
 }
 
@@ -113,4 +119,8 @@ void usb_app_run()
 {
   usb_app.HandleIrq();
   usb_app.Run();
+
+  #if UIO_SLCAN_ENABLE && UIO_CAN_COUNT
+    g_slcan.Run();
+  #endif
 }
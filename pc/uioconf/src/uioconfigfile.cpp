@@ -90,11 +90,11 @@ bool TUioConfig::ParseConfigLine(string idstr)
 		i = ParseIntAssignment();
 		if (i & 1)
 		{
-			dout_value = 0xFFFFFFFF;
+			dout_value = 0xFFFFFFFFFFFFFFFFull;
 		}
 		else
 		{
-			dout_value = 0x00000000;
+			dout_value = 0;
 		}
 	}
 	else if ("DOUT" == idstr)
@@ -112,11 +112,11 @@ bool TUioConfig::ParseConfigLine(string idstr)
 
 		if (i & 1)
 		{
-			dout_value |= (1 << idx);
+			dout_value |= (uint64_t(1) << idx);
 		}
 		else
 		{
-			dout_value &= ~(1 << idx);
+			dout_value &= ~(uint64_t(1) << idx);
 		}
 	}
 	else if (("AOUT" == idstr) || ("ANA_OUT" == idstr))
@@ -326,6 +326,10 @@ bool TUioConfig::ParsePinConf()
   {
   	pintype = UIO_PINTYPE_CAN;
   }
+  else if (sp->UCComparePrev("COUNTER") || sp->UCComparePrev("CNT"))
+  {
+  	pintype = UIO_PINTYPE_COUNTER;
+  }
   else if (sp->UCComparePrev("PINTYPE"))
   {
   	// example: PINTYPE(129)
@@ -542,7 +546,13 @@ bool TUioConfig::SaveToDevice()
 	printf("Setting output defaults...\n");
 	try
 	{
-		udocomm.UdoWrite(0x0300, 0, &dout_value, 4);
+		uint32_t dv_douts = uint32_t(dout_value);
+		udocomm.UdoWrite(0x0300, 0, &dv_douts, 4);
+		uint32_t dv_douts_hi = uint32_t(dout_value >> 32);
+		if (dv_douts_hi)  // older firmware does not have this object
+		{
+			udocomm.UdoWrite(0x0301, 0, &dv_douts_hi, 4);
+		}
 	}
 	catch (EUdoAbort & e)
 	{
@@ -18,8 +18,8 @@
 #define UIO_PWM_COUNT       8
 #define UIO_ADC_COUNT      32
 #define UIO_DAC_COUNT       8
-#define UIO_DOUT_COUNT     32
-#define UIO_DIN_COUNT      32
+#define UIO_DOUT_COUNT     64
+#define UIO_DIN_COUNT      64
 #define UIO_LEDBLP_COUNT   16
 
 #define UIO_PINTYPE_PASSIVE          0 // default configuration
@@ -34,6 +34,7 @@
 #define UIO_PINTYPE_UART             9
 #define UIO_PINTYPE_CLKOUT          10
 #define UIO_PINTYPE_CAN             11
+#define UIO_PINTYPE_COUNTER         12
 
 
 class TUioConfig : public TConfigFileParser
@@ -52,7 +53,7 @@ public:
 public:
 	uint32_t       pinconf[UIO_MAX_PINS];
 
-	uint32_t       dout_value = 0;
+	uint64_t       dout_value = 0;
 	uint16_t       aout_value[UIO_DAC_COUNT];
 	uint16_t       pwm_value[UIO_PWM_COUNT];
 	uint32_t       pwm_freq[UIO_PWM_COUNT];
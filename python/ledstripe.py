@@ -5,57 +5,46 @@ from commh_udoip import udoip_commh
 import sys
 import time
 
-def SetBarrBit(barr, bitidx):
-	byteidx = (bitidx >> 3)
-	sbidx = 7 - (bitidx & 7)
-	barr[byteidx] |= (1 << sbidx)
+# The device expands the packed RGB data into the WS2812 SPI bit stream (SPI mode 3 = LED stripe)
 
 class UioLedStripe:
 	def __init__(self, aconn, aledcount):
 		self.conn = aconn
 		self.ledcount = aledcount
+		self.srcoffs = 0x0000      # packed RGB data in the MPRAM
+		self.encoffs = 0x1000      # encoded SPI frame buffers in the MPRAM (two frames)
 		self.resetbytes = 15
-		self.tailresetbytes = 15
-		self.spidata = bytearray()
-		self.SetLedCount(aledcount)
+		self.leddata = bytearray()
 		self.conn.WriteU32(0x1600, 0, 2400000)  # set SPI speed to 2.4 MHz
+		self.conn.WriteU16(0x160A, 0, self.srcoffs)
+		self.conn.WriteU8(0x160C, 0, 0)  # format: RGB
+		self.conn.WriteU8(0x160C, 1, self.resetbytes)
+		self.conn.WriteU16(0x160C, 2, self.encoffs)
+		self.SetLedCount(aledcount)
 
 	def SetLedCount(self, aledcount):
-		self.spidata = bytearray()
 		self.ledcount = aledcount
-		for n in range(0, self.resetbytes):
-			self.spidata.extend([0])
-		for n in range(0, self.ledcount):
-			self.spidata.extend([0,0,0, 0,0,0, 0,0,0])
-		for n in range(0, self.tailresetbytes):
-			self.spidata.extend([0])
-		#/
-		self.conn.WriteU16(0x1601, 0, len(self.spidata))  # length
+		self.leddata = bytearray(3 * self.ledcount)
+		self.conn.WriteU16(0x160B, 0, self.ledcount)
 
 	def SetLed(self, aidx, ar, ag, ab):
-		ldata = bytearray([0,0,0, 0,0,0, 0,0,0])
-		grbcode = (ag << 16) | (ar << 8) | ab
-		cbmask = (1 << 23)
-		bidx = 0
-		while cbmask:
-			SetBarrBit(ldata, bidx)
-			if grbcode & cbmask:
-				SetBarrBit(ldata, bidx+1)
-			#/
-			bidx += 3
-			cbmask = (cbmask >> 1)
-		#/
-		ledpos = self.resetbytes + 9 * aidx
-		for n in range(0, 9):
-			self.spidata[ledpos + n] = ldata[n]
-		#/
+		ledpos = 3 * aidx
+		self.leddata[ledpos + 0] = ar
+		self.leddata[ledpos + 1] = ag
+		self.leddata[ledpos + 2] = ab
 
 	def Update(self):
-		while self.conn.ReadU8(0x1602, 0) != 0:
-			pass
-		self.conn.WriteBlob(0xC000, 0, self.spidata)  # upload the SPI data
-		#conn.write_uint(0x1601, len(self.spidata), 2)  # length
-		self.conn.WriteU8(0x1602, 0, 1)  # start
+		# the device accepts the next frame while the previous one is shifted out
+		while True:
+			try:
+				self.conn.WriteBlob(0xC000, self.srcoffs, self.leddata)  # upload the RGB data
+				self.conn.WriteU8(0x1602, 0, 3)  # encode and start
+				return
+			except EUdoAbort as e:
+				if e.errorcode != UDOERR_BUSY:
+					raise
+			#/
+		#/
 	#/
 #/  class UioLedStripe
 